@@ -0,0 +1,405 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <glib/gstdio.h>
+#include <sys/resource.h>
+#include <stdio.h>
+#include <algorithm>
+
+#include "batch.h"
+#include "msg.h"
+#include "utils.h"
+
+using std::string;
+using std::vector;
+using std::make_pair;
+
+namespace Gst123
+{
+
+/* playbin flags */
+static const int GST_PLAY_FLAG_VIDEO = (1 << 0);
+static const int GST_PLAY_FLAG_TEXT  = (1 << 2);
+
+Batch::Batch (const vector<string>& uris) :
+  benchmark (false),
+  uris (uris),
+  loop (NULL),
+  next_index (0),
+  n_running (0),
+  n_ok (0),
+  n_failed (0),
+  total_media_time (0),
+  start_time (0),
+  max_peak_rss_kb (0)
+{
+}
+
+Batch::~Batch()
+{
+  for (size_t i = 0; i < jobs.size(); i++)
+    {
+      Job *job = jobs[i];
+      if (job->bus_watch)
+        g_source_remove (job->bus_watch);
+      if (job->playbin)
+        {
+          gst_element_set_state (job->playbin, GST_STATE_NULL);
+          gst_object_unref (job->playbin);
+        }
+      delete job;
+    }
+  if (loop)
+    g_main_loop_unref (loop);
+}
+
+static string
+display_name (const string& uri)
+{
+  string result = uri;
+
+  char *filename = g_filename_from_uri (uri.c_str(), NULL, NULL);
+  if (filename)
+    {
+      result = filename;
+      g_free (filename);
+    }
+  return result;
+}
+
+static double
+get_cpu_time()
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+
+  return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * (1.0 / 1000000.0) +
+         usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * (1.0 / 1000000.0);
+}
+
+/* maximum resident set size of the whole process so far */
+static long
+get_process_peak_rss_kb()
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+
+  return usage.ru_maxrss;
+}
+
+/* reset the peak resident set size (VmHWM) of the process (Linux only) */
+static bool
+reset_peak_rss()
+{
+  FILE *file = fopen ("/proc/self/clear_refs", "w");
+  if (!file)
+    return false;
+
+  bool ok = fputs ("5", file) >= 0;
+  ok = (fclose (file) == 0) && ok;
+  return ok;
+}
+
+/* peak resident set size since the last reset_peak_rss() */
+static long
+get_peak_rss_kb()
+{
+  long result = -1;
+
+  FILE *file = fopen ("/proc/self/status", "r");
+  if (file)
+    {
+      char line[256];
+      while (result < 0 && fgets (line, sizeof (line), file))
+        if (sscanf (line, "VmHWM: %ld kB", &result) != 1)
+          result = -1;
+      fclose (file);
+    }
+  return result;
+}
+
+bool
+Batch::create_job (Job *job, GstElement *audio_sink, GstElement *video_sink, int disable_flags, string& error)
+{
+  job->playbin = gst_element_factory_make ("playbin", NULL);
+  if (!job->playbin)
+    {
+      error = "failed to create playbin";
+      return false;
+    }
+  gst_object_ref_sink (job->playbin);
+  g_object_set (G_OBJECT (job->playbin), "audio-sink", audio_sink, "video-sink", video_sink, NULL);
+
+  int flags;
+  g_object_get (G_OBJECT (job->playbin), "flags", &flags, NULL);
+  g_object_set (G_OBJECT (job->playbin), "flags", flags & ~disable_flags, NULL);
+
+  GstBus *bus = gst_pipeline_get_bus (GST_PIPELINE (job->playbin));
+  job->bus_watch = gst_bus_add_watch (bus, bus_callback, job);
+  gst_object_unref (bus);
+
+  return true;
+}
+
+bool
+Batch::init_render (guint n_jobs, const string& pattern, string& error)
+{
+  if (!Render::is_per_track_pattern (pattern))
+    {
+      error = "batch mode needs one output file per track (use %n or %b in the render filename)";
+      return false;
+    }
+  if (n_jobs > uris.size())
+    n_jobs = uris.size();
+  if (n_jobs < 1)
+    n_jobs = 1;
+
+  for (guint j = 0; j < n_jobs; j++)
+    {
+      Job *job = new Job (this);
+      jobs.push_back (job);
+
+      if (!job->render.init (pattern, error))
+        return false;
+
+      /* only audio is rendered, so we don't need to decode video or subtitles */
+      GstElement *video_sink = gst_element_factory_make ("fakesink", NULL);
+      if (!create_job (job, job->render.sink(), video_sink, GST_PLAY_FLAG_VIDEO | GST_PLAY_FLAG_TEXT, error))
+        return false;
+    }
+  return true;
+}
+
+bool
+Batch::init_benchmark (bool decode_video, string& error)
+{
+  /* we only use one job here, otherwise the cpu time per file can't be measured */
+  benchmark = true;
+
+  Job *job = new Job (this);
+  jobs.push_back (job);
+
+  GstElement *audio_sink = gst_element_factory_make ("fakesink", NULL);
+  GstElement *video_sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (G_OBJECT (audio_sink), "sync", FALSE, NULL);
+  g_object_set (G_OBJECT (video_sink), "sync", FALSE, NULL);
+
+  int disable_flags = GST_PLAY_FLAG_TEXT;
+  if (!decode_video)
+    disable_flags |= GST_PLAY_FLAG_VIDEO;
+
+  return create_job (job, audio_sink, video_sink, disable_flags, error);
+}
+
+bool
+Batch::start_next (Job *job)
+{
+  if (next_index >= uris.size())
+    return false;
+
+  job->index = next_index++;
+  if (!benchmark)
+    job->location = job->render.set_track (job->index + 1, uris[job->index]);
+  job->tags = Tags();
+  job->start_time = get_time();
+  job->start_audio_time = job->render.rendered_time();
+  job->start_cpu_time = get_cpu_time();
+  if (benchmark)
+    job->peak_rss_reset = reset_peak_rss();
+
+  g_object_set (G_OBJECT (job->playbin), "uri", uris[job->index].c_str(), NULL);
+  gst_element_set_state (job->playbin, GST_STATE_PLAYING);
+
+  n_running++;
+  return true;
+}
+
+void
+Batch::finish_job (Job *job, const string& error)
+{
+  double wall_time = get_time() - job->start_time;
+  double cpu_time = get_cpu_time() - job->start_cpu_time;
+  double media_time = 0;
+  long   peak_rss_kb = -1;
+
+  if (benchmark)
+    {
+      if (job->peak_rss_reset)
+        peak_rss_kb = get_peak_rss_kb();
+      if (peak_rss_kb < 0)
+        peak_rss_kb = get_process_peak_rss_kb();   // can't be measured per file
+
+      /* resetting VmHWM also resets ru_maxrss, so keep track of the process peak here */
+      max_peak_rss_kb = std::max (max_peak_rss_kb, peak_rss_kb);
+
+      gint64 len;
+      if (gst_element_query_duration (job->playbin, GST_FORMAT_TIME, &len) && len > 0)
+        media_time = len * (1.0 / GST_SECOND);
+    }
+  else
+    {
+      media_time = job->render.rendered_time() - job->start_audio_time;
+    }
+
+  gst_element_set_state (job->playbin, GST_STATE_NULL);
+  n_running--;
+
+  double realtime_factor = wall_time > 0 ? media_time / wall_time : 0.0;
+  string name = display_name (uris[job->index]);
+
+  if (error.empty())
+    {
+      n_ok++;
+      total_media_time += media_time;
+    }
+  else
+    {
+      n_failed++;
+    }
+
+  if (benchmark)
+    {
+      printf ("{\"type\":\"file\",\"uri\":%s,\"codec\":%s,\"vcodec\":%s,\"media_time\":%.3f,\"wall_time\":%.3f,"
+              "\"cpu_time\":%.3f,\"realtime_factor\":%.2f,\"peak_rss_kb\":%ld,\"error\":%s}\n",
+              json_string (uris[job->index]).c_str(), json_string (job->tags.codec).c_str(),
+              json_string (job->tags.vcodec).c_str(), media_time, wall_time, cpu_time, realtime_factor, peak_rss_kb,
+              error.empty() ? "null" : json_string (error).c_str());
+      fflush (stdout);
+
+      if (error.empty())
+        {
+          CodecStats& stats = codec_stats[make_pair (job->tags.codec, job->tags.vcodec)];
+          stats.files++;
+          stats.media_time += media_time;
+          stats.wall_time += wall_time;
+          stats.cpu_time += cpu_time;
+        }
+    }
+  else if (error.empty())
+    {
+      Msg::print ("[%u/%u] %s -> %s: %.2f seconds of audio in %.2f seconds (realtime factor %.1fx)\n",
+                  job->index + 1, guint (uris.size()), name.c_str(), job->location.c_str(),
+                  media_time, wall_time, realtime_factor);
+      Msg::flush();
+    }
+  else
+    {
+      // don't leave incomplete output files behind
+      g_unlink (job->location.c_str());
+
+      Msg::print ("[%u/%u] %s: Error: %s\n", job->index + 1, guint (uris.size()), name.c_str(), error.c_str());
+      Msg::flush();
+    }
+
+  if (!start_next (job) && n_running == 0)
+    g_main_loop_quit (loop);
+}
+
+gboolean
+Batch::bus_callback (GstBus *bus, GstMessage *message, gpointer data)
+{
+  Job *job = static_cast<Job *> (data);
+
+  switch (GST_MESSAGE_TYPE (message))
+    {
+      case GST_MESSAGE_ERROR:
+        {
+          GError *err = NULL;
+          gchar *debug = NULL;
+
+          gst_message_parse_error (message, &err, &debug);
+          string error = err ? err->message : "<NULL Error>";
+          g_clear_error (&err);
+          g_free (debug);
+
+          job->batch->finish_job (job, error);
+        }
+        break;
+      case GST_MESSAGE_EOS:
+        job->batch->finish_job (job, "");
+        break;
+      case GST_MESSAGE_TAG:
+        {
+          GstTagList *tag_list = NULL;
+          gst_message_parse_tag (message, &tag_list);
+          gst_tag_list_foreach (tag_list, collect_tags, &job->tags);
+          gst_tag_list_unref (tag_list);
+        }
+        break;
+      default:
+        /* unhandled message */
+        break;
+    }
+  return TRUE;
+}
+
+void
+Batch::print_summary()
+{
+  double wall_time = get_time() - start_time;
+
+  Msg::print ("\n%u files rendered, %u failed: %.2f seconds of audio in %.2f seconds using %u jobs (realtime factor %.1fx)\n",
+              n_ok, n_failed, total_media_time, wall_time, guint (jobs.size()),
+              wall_time > 0 ? total_media_time / wall_time : 0.0);
+}
+
+void
+Batch::print_benchmark_summary()
+{
+  for (CodecStatsMap::const_iterator si = codec_stats.begin(); si != codec_stats.end(); si++)
+    {
+      const CodecStats& stats = si->second;
+
+      printf ("{\"type\":\"codec\",\"codec\":%s,\"vcodec\":%s,\"files\":%u,\"media_time\":%.3f,"
+              "\"wall_time\":%.3f,\"cpu_time\":%.3f,\"realtime_factor\":%.2f}\n",
+              json_string (si->first.first).c_str(), json_string (si->first.second).c_str(),
+              stats.files, stats.media_time, stats.wall_time, stats.cpu_time,
+              stats.wall_time > 0 ? stats.media_time / stats.wall_time : 0.0);
+    }
+  double wall_time = get_time() - start_time;
+
+  printf ("{\"type\":\"total\",\"files\":%u,\"failed\":%u,\"media_time\":%.3f,\"wall_time\":%.3f,"
+          "\"cpu_time\":%.3f,\"realtime_factor\":%.2f,\"process_peak_rss_kb\":%ld}\n",
+          n_ok, n_failed, total_media_time, wall_time, get_cpu_time(),
+          wall_time > 0 ? total_media_time / wall_time : 0.0, std::max (max_peak_rss_kb, get_process_peak_rss_kb()));
+  fflush (stdout);
+}
+
+int
+Batch::run()
+{
+  loop = g_main_loop_new (NULL, FALSE);
+  start_time = get_time();
+
+  for (size_t i = 0; i < jobs.size(); i++)
+    start_next (jobs[i]);
+
+  if (n_running > 0)
+    g_main_loop_run (loop);
+
+  if (benchmark)
+    print_benchmark_summary();
+  else
+    print_summary();
+
+  return n_failed ? 1 : 0;
+}
+
+}
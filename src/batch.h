@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef GST123_BATCH_H
+#define GST123_BATCH_H
+
+#include <gst/gst.h>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "render.h"
+#include "tags.h"
+
+namespace Gst123
+{
+
+/*
+ * Batch mode: render all files of the playlist using multiple pipelines
+ *
+ * Each job owns one playbin with its own Render sink; whenever a job is done
+ * with a file, it picks the next file from the work queue. All pipelines are
+ * driven from one main loop, the actual decoding/encoding runs in the
+ * GStreamer streaming threads, so N jobs keep up to N cpu cores busy.
+ *
+ * In benchmark mode, a single job decodes all files into fakesinks (without
+ * clock sync) and prints machine readable (JSON) statistics per file and per
+ * codec.
+ */
+class Batch
+{
+  struct Job
+  {
+    Batch      *batch;
+    GstElement *playbin;
+    guint       bus_watch;
+    Render      render;
+    guint       index;
+    std::string location;
+    double      start_time;
+    double      start_audio_time;
+    double      start_cpu_time;
+    bool        peak_rss_reset;
+    Tags        tags;
+
+    Job (Batch *batch) :
+      batch (batch),
+      playbin (NULL),
+      bus_watch (0),
+      index (0),
+      start_time (0),
+      start_audio_time (0),
+      start_cpu_time (0),
+      peak_rss_reset (false)
+    {
+    }
+  };
+  struct CodecStats
+  {
+    guint  files;
+    double media_time;
+    double wall_time;
+    double cpu_time;
+
+    CodecStats() : files (0), media_time (0), wall_time (0), cpu_time (0)
+    {
+    }
+  };
+  typedef std::map<std::pair<std::string, std::string>, CodecStats> CodecStatsMap;
+
+  bool                     benchmark;
+  std::vector<std::string> uris;
+  std::vector<Job *>       jobs;
+  GMainLoop               *loop;
+  guint                    next_index;
+  guint                    n_running;
+  guint                    n_ok;
+  guint                    n_failed;
+  double                   total_media_time;
+  double                   start_time;
+  long                     max_peak_rss_kb;
+  CodecStatsMap            codec_stats;
+
+  bool create_job (Job *job, GstElement *audio_sink, GstElement *video_sink, int disable_flags, std::string& error);
+  bool start_next (Job *job);
+  void finish_job (Job *job, const std::string& error);
+  void print_summary();
+  void print_benchmark_summary();
+
+  static gboolean bus_callback (GstBus *bus, GstMessage *message, gpointer data);
+
+public:
+  Batch (const std::vector<std::string>& uris);
+  ~Batch();
+
+  bool init_render (guint n_jobs, const std::string& pattern, std::string& error);
+  bool init_benchmark (bool decode_video, std::string& error);
+  int run();
+};
+
+}
+
+#endif
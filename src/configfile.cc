@@ -19,6 +19,7 @@
  */
 #include "configfile.h"
 #include "microconf.h"
+#include "keyhandler.h"
 
 #include <stdlib.h>
 
@@ -47,6 +48,57 @@ ConfigFile::visualization() const
   return m_visualization;
 }
 
+const std::vector<string>&
+ConfigFile::library_dirs() const
+{
+  return m_library_dirs;
+}
+
+/* returns the key code a key is bound to (via bind_key in the config file) */
+int
+ConfigFile::map_key (int key) const
+{
+  std::map<int, int>::const_iterator ki = m_key_bindings.find (key);
+  if (ki != m_key_bindings.end())
+    return ki->second;
+  return key;
+}
+
+/* key names: a single character or one of the special key names */
+bool
+ConfigFile::parse_key (const string& name, int& key)
+{
+  static const struct
+  {
+    const char *name;
+    int         key;
+  } named_keys[] =
+  {
+    { "up",        KEY_HANDLER_UP },
+    { "down",      KEY_HANDLER_DOWN },
+    { "left",      KEY_HANDLER_LEFT },
+    { "right",     KEY_HANDLER_RIGHT },
+    { "page_up",   KEY_HANDLER_PAGE_UP },
+    { "page_down", KEY_HANDLER_PAGE_DOWN },
+    { "backspace", KEY_HANDLER_BACKSPACE },
+    { "space",     ' ' },
+  };
+  for (size_t i = 0; i < sizeof (named_keys) / sizeof (named_keys[0]); i++)
+    {
+      if (name == named_keys[i].name)
+        {
+          key = named_keys[i].key;
+          return true;
+        }
+    }
+  if (name.size() == 1)
+    {
+      key = (unsigned char) name[0];
+      return true;
+    }
+  return false;
+}
+
 ConfigFile::ConfigFile()
 {
   char *home = getenv ("XDG_CONFIG_HOME");
@@ -74,7 +126,7 @@ ConfigFile::ConfigFile()
     }
   while (cfg.next())
     {
-      string str;
+      string str, str2;
       if (cfg.command ("audio_output", str))
         {
           m_audio_output = str;
@@ -83,6 +135,18 @@ ConfigFile::ConfigFile()
         {
           m_visualization = str;
         }
+      else if (cfg.command ("library", str))
+        {
+          m_library_dirs.push_back (str);
+        }
+      else if (cfg.command ("bind_key", str, str2))
+        {
+          int key, target;
+          if (!parse_key (str, key) || !parse_key (str2, target))
+            cfg.die_if_unknown();
+
+          m_key_bindings[key] = target;
+        }
       else
         {
           cfg.die_if_unknown();
@@ -18,11 +18,15 @@
  * Boston, MA 02111-1307, USA.
  */
 #include <string>
+#include <map>
+#include <vector>
 
 class ConfigFile
 {
-  std::string m_audio_output;
-  std::string m_visualization;
+  std::string         m_audio_output;
+  std::string         m_visualization;
+  std::map<int, int>  m_key_bindings;
+  std::vector<std::string> m_library_dirs;
 
 public:
   static ConfigFile& the();       // Singleton
@@ -31,4 +35,8 @@ public:
 
   std::string audio_output() const;
   std::string visualization() const;
+  int map_key (int key) const;
+  const std::vector<std::string>& library_dirs() const;
+
+  static bool parse_key (const std::string& name, int& key);
 };
@@ -0,0 +1,185 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "cueparser.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+
+using std::string;
+
+using namespace Gst123;
+
+static const char * const cue_content_types[] = { "application/x-cue", NULL };
+static const char * const cue_magics[] = { "REM ", "PERFORMER ", "TITLE ", "FILE ", "CATALOG ", "CDTEXTFILE ", "SONGWRITER ", NULL };
+
+const PlaylistFormat&
+CUEParser::format()
+{
+  static const PlaylistFormat cue_format = { cue_content_types, cue_magics, false };
+  return cue_format;
+}
+
+/* returns the first argument, which may be quoted: FILE "foo bar.flac" WAVE */
+static string
+first_arg (const string& args)
+{
+  if (!args.empty() && args[0] == '"')
+    {
+      size_t end = args.find ('"', 1);
+      return args.substr (1, end == string::npos ? string::npos : end - 1);
+    }
+  return args.substr (0, args.find (' '));
+}
+
+/* mm:ss:ff, with 75 frames per second */
+static double
+parse_cue_time (const string& str)
+{
+  unsigned int min, sec, frames;
+  if (sscanf (str.c_str(), "%u:%u:%u", &min, &sec, &frames) != 3)
+    return -1;
+  return min * 60 + sec + frames / 75.0;
+}
+
+struct CUETrack
+{
+  bool   audio;
+  string title;
+  string performer;
+  double start;
+};
+
+static PlaylistEntry
+make_entry (const string& file, const CUETrack& track, const string& album_performer)
+{
+  PlaylistEntry entry (file);
+
+  string performer = track.performer != "" ? track.performer : album_performer;
+  if (performer != "" && track.title != "")
+    entry.title = performer + " - " + track.title;
+  else
+    entry.title = track.title;
+  entry.start = track.start;
+  return entry;
+}
+
+// Parse the cue sheet
+// Tracks are passed on once the start of the following track (or the end
+// of the file) is known, because the end of one track is the start of the next
+int
+CUEParser::parse (PlaylistEntryHandler& output, IOStream *stream)
+{
+  int ret = 0;
+
+  string file, album_performer;
+  CUETrack track = { false, "", "", -1 };
+  PlaylistEntry pending;
+  bool have_pending = false;
+  bool in_track = false;
+
+  do
+    {
+      string curline = stream->get_current_line();
+
+      if (curline.compare (0, 3, "\xef\xbb\xbf") == 0)
+        curline.erase (0, 3);
+      while (!curline.empty() && isspace (curline[0]))
+        curline.erase (0, 1);
+      while (!curline.empty() && isspace (curline[curline.size() - 1]))  // cue sheets often have \r\n line endings
+        curline.erase (curline.size() - 1);
+
+      size_t space_pos = curline.find (' ');
+      if (space_pos == string::npos)
+        continue;
+
+      string command = curline.substr (0, space_pos);
+      string args = curline.substr (space_pos + 1);
+      while (!args.empty() && isspace (args[0]))
+        args.erase (0, 1);
+
+      if (command == "FILE")
+        {
+          if (have_pending)
+            {
+              output.add_entry (pending);   // last track of the previous file plays until the end
+              have_pending = false;
+            }
+          file = first_arg (args);
+          in_track = false;
+        }
+      else if (command == "TRACK")
+        {
+          in_track = true;
+          track.audio = args.find ("AUDIO") != string::npos;
+          track.title = "";
+          track.performer = "";
+          track.start = -1;
+        }
+      else if (command == "TITLE" && in_track)
+        {
+          track.title = first_arg (args);
+        }
+      else if (command == "PERFORMER")
+        {
+          if (in_track)
+            track.performer = first_arg (args);
+          else
+            album_performer = first_arg (args);
+        }
+      else if (command == "INDEX" && in_track && track.audio && file != "")
+        {
+          int index = atoi (args.c_str());
+          double start = parse_cue_time (args.substr (args.find (' ') + 1));
+
+          if (index == 1 && start >= 0)
+            {
+              if (have_pending)
+                {
+                  pending.end = start;
+                  pending.duration = pending.end - pending.start;
+                  output.add_entry (pending);
+                }
+              track.start = start;
+              pending = make_entry (file, track, album_performer);
+              have_pending = true;
+            }
+        }
+    }
+  while ((ret = stream->readline()) >= 0);
+
+  if (have_pending)
+    output.add_entry (pending);
+
+  if (ret == IO_STREAM_EOF)  // EOF is not an error
+    ret = 0;
+
+  if (ret < 0)
+    ret = errno;
+
+  return ret;
+}
+
+string
+CUEParser::str_error (int error)
+{
+  return "";
+}
@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __CUE_PARSER_H__
+#define __CUE_PARSER_H__
+
+#include "playlist.h"
+
+namespace Gst123
+{
+
+/*
+ * Cue sheet parser
+ *
+ * Each audio TRACK becomes a virtual track: the FILE with the start position
+ * of INDEX 01, ending where the next track of the same file starts.
+ */
+struct CUEParser : public PlaylistParser
+{
+  int parse (PlaylistEntryHandler& output, IOStream *stream);
+  const PlaylistFormat& format();
+  std::string str_error (int error);
+};
+
+}
+
+#endif
@@ -0,0 +1,299 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "discovery.h"
+
+#include <glib/gstdio.h>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using std::string;
+using std::vector;
+
+namespace Gst123
+{
+
+/* files which can't be probed within this time are skipped */
+static const GstClockTime DISCOVER_TIMEOUT = 10 * GST_SECOND;
+
+/* pushed into the queue to stop a worker thread */
+static char stop_marker;
+
+Discovery::Handler::~Handler()
+{
+  // virtual dtor
+}
+
+Discovery::State::State() :
+  ref_count (1),
+  queue (g_async_queue_new()),
+  idle_pending (false),
+  cancelled (false),
+  handler (NULL)
+{
+  g_mutex_init (&mutex);
+}
+
+Discovery::State::~State()
+{
+  gpointer item;
+  while ((item = g_async_queue_try_pop (queue)))
+    {
+      if (item != &stop_marker)
+        g_free (item);
+    }
+  g_async_queue_unref (queue);
+  g_mutex_clear (&mutex);
+}
+
+void
+Discovery::State::unref()
+{
+  if (g_atomic_int_dec_and_test (&ref_count))
+    delete this;
+}
+
+bool
+Discovery::State::is_cancelled()
+{
+  g_mutex_lock (&mutex);
+  bool result = cancelled;
+  g_mutex_unlock (&mutex);
+
+  return result;
+}
+
+static void
+get_tag (const GstTagList *tags, const char *tag, string& value)
+{
+  gchar *str;
+
+  if (value == "" && gst_tag_list_get_string (tags, tag, &str))
+    {
+      value = str;
+      g_free (str);
+    }
+}
+
+bool
+Discovery::probe (GstDiscoverer *discoverer, const char *uri, Metadata& metadata)
+{
+  GstDiscovererInfo *info = gst_discoverer_discover_uri (discoverer, uri, NULL);
+  if (!info)
+    return false;
+
+  bool ok = (gst_discoverer_info_get_result (info) == GST_DISCOVERER_OK);
+  if (ok)
+    {
+      GstClockTime duration = gst_discoverer_info_get_duration (info);
+      if (GST_CLOCK_TIME_IS_VALID (duration) && duration > 0)
+        metadata.duration = duration / double (GST_SECOND);
+
+      GList *streams = gst_discoverer_info_get_audio_streams (info);
+      for (GList *si = streams; si; si = si->next)
+        {
+          const GstTagList *tags = gst_discoverer_stream_info_get_tags (GST_DISCOVERER_STREAM_INFO (si->data));
+          if (tags)
+            {
+              get_tag (tags, GST_TAG_TITLE, metadata.title);
+              get_tag (tags, GST_TAG_ARTIST, metadata.artist);
+              get_tag (tags, GST_TAG_ALBUM, metadata.album);
+            }
+        }
+      gst_discoverer_stream_info_list_free (streams);
+    }
+  gst_discoverer_info_unref (info);
+
+  return ok;
+}
+
+static gint64
+file_mtime (const char *uri)
+{
+  gint64 mtime = -1;
+
+  char *filename = g_filename_from_uri (uri, NULL, NULL);
+  if (filename)
+    {
+      GStatBuf st;
+      if (g_stat (filename, &st) == 0)
+        mtime = st.st_mtime;
+      g_free (filename);
+    }
+  return mtime;
+}
+
+bool
+Discovery::lookup_or_probe (GstDiscoverer *discoverer, const char *uri, Metadata& metadata)
+{
+  MetadataStore::Entry entry;
+  gint64 mtime = file_mtime (uri);
+
+  if (mtime >= 0 && MetadataStore::the().lookup (uri, entry) && entry.mtime == mtime)
+    {
+      metadata = entry.metadata;
+      return true;
+    }
+  if (!probe (discoverer, uri, metadata))
+    return false;
+
+  if (mtime >= 0)
+    {
+      entry.mtime = mtime;
+      entry.metadata = metadata;
+      MetadataStore::the().set (uri, entry);
+    }
+  return true;
+}
+
+gpointer
+Discovery::worker_func (gpointer data)
+{
+  State *state = static_cast<State *> (data);
+
+#ifdef __linux__
+  /* on linux, the nice value is per thread; the discoverer's streaming threads inherit it */
+  setpriority (PRIO_PROCESS, syscall (SYS_gettid), 19);
+#endif
+
+  GstDiscoverer *discoverer = gst_discoverer_new (DISCOVER_TIMEOUT, NULL);
+  while (discoverer)
+    {
+      gpointer item = g_async_queue_pop (state->queue);
+      if (item == &stop_marker)
+        break;
+
+      char *uri = static_cast<char *> (item);
+      Result result;
+      if (!state->is_cancelled() && lookup_or_probe (discoverer, uri, result.metadata))
+        {
+          result.uri = uri;
+          g_mutex_lock (&state->mutex);
+          if (!state->cancelled)
+            {
+              state->results.push_back (result);
+
+              /* one idle callback delivers all results found until it runs */
+              if (!state->idle_pending)
+                {
+                  state->idle_pending = true;
+                  g_atomic_int_inc (&state->ref_count);
+                  g_idle_add_full (G_PRIORITY_LOW, idle_deliver, state, NULL);
+                }
+            }
+          g_mutex_unlock (&state->mutex);
+        }
+      g_free (uri);
+    }
+  if (discoverer)
+    g_object_unref (discoverer);
+
+  state->unref();
+  return NULL;
+}
+
+gboolean
+Discovery::idle_deliver (gpointer data)
+{
+  State *state = static_cast<State *> (data);
+  vector<Result> results;
+
+  g_mutex_lock (&state->mutex);
+  results.swap (state->results);
+  state->idle_pending = false;
+  bool cancelled = state->cancelled;
+  g_mutex_unlock (&state->mutex);
+
+  for (vector<Result>::const_iterator ri = results.begin(); ri != results.end() && !cancelled; ri++)
+    state->handler->metadata_discovered (ri->uri, ri->metadata);
+
+  state->unref();
+  return FALSE;
+}
+
+Discovery::Discovery() :
+  state (NULL),
+  n_workers (0)
+{
+}
+
+Discovery::~Discovery()
+{
+  /* workers may be busy with a slow file, so we don't wait for them;
+   * the last one will free the shared state
+   */
+  cancel();
+}
+
+void
+Discovery::start (int workers, Handler *handler)
+{
+  g_return_if_fail (state == NULL);
+
+  state = new State();
+  state->handler = handler;
+  n_workers = workers;
+
+  for (int i = 0; i < n_workers; i++)
+    {
+      g_atomic_int_inc (&state->ref_count);
+      GThread *thread = g_thread_new ("discovery", worker_func, state);
+      g_thread_unref (thread);
+    }
+}
+
+bool
+Discovery::enabled() const
+{
+  return state != NULL;
+}
+
+/* queues a file for probing; other uris are ignored */
+void
+Discovery::add (const string& uri)
+{
+  if (state && uri.compare (0, 5, "file:") == 0)
+    g_async_queue_push (state->queue, g_strdup (uri.c_str()));
+}
+
+void
+Discovery::cancel()
+{
+  if (!state)
+    return;
+
+  g_mutex_lock (&state->mutex);
+  state->cancelled = true;
+  state->results.clear();
+  g_mutex_unlock (&state->mutex);
+
+  /* stop the workers before they probe the remaining files */
+  for (int i = 0; i < n_workers; i++)
+    g_async_queue_push_front (state->queue, &stop_marker);
+
+  state->unref();
+  state = NULL;
+}
+
+}
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef GST123_DISCOVERY_H
+#define GST123_DISCOVERY_H
+
+#include "metadatastore.h"
+#include <gst/pbutils/pbutils.h>
+#include <string>
+#include <vector>
+
+namespace Gst123
+{
+
+/*
+ * Reads durations and tags of files in the background
+ *
+ * A number of worker threads (each with its own GstDiscoverer) probe the
+ * files in the order they were added, with a low cpu priority, so that
+ * playback isn't disturbed. Results are stored in the MetadataStore and
+ * passed to the handler in the main thread; files which are in the store
+ * (and didn't change since) aren't probed again.
+ *
+ * Only local files are probed: probing network streams (radio) would
+ * connect to the server for every entry.
+ */
+class Discovery
+{
+public:
+  struct Handler
+  {
+    virtual void metadata_discovered (const std::string& uri, const Metadata& metadata) = 0;
+
+    virtual ~Handler();
+  };
+
+private:
+  struct Result
+  {
+    std::string uri;
+    Metadata    metadata;
+  };
+
+  /* shared between main thread and worker threads; freed by whoever drops the last reference */
+  struct State
+  {
+    gint                ref_count;
+    GMutex              mutex;
+    GAsyncQueue        *queue;          // uris to probe
+    std::vector<Result> results;        // protected by mutex
+    bool                idle_pending;   // protected by mutex
+    bool                cancelled;      // protected by mutex
+    Handler            *handler;        // only used in main thread
+
+    State();
+    ~State();
+
+    bool is_cancelled();
+    void unref();
+  };
+
+  State *state;
+  int    n_workers;
+
+  static bool probe (GstDiscoverer *discoverer, const char *uri, Metadata& metadata);
+  static bool lookup_or_probe (GstDiscoverer *discoverer, const char *uri, Metadata& metadata);
+  static gpointer worker_func (gpointer data);
+  static gboolean idle_deliver (gpointer data);
+
+public:
+  Discovery();
+  ~Discovery();
+
+  void start (int workers, Handler *handler);
+  void add (const std::string& uri);
+  bool enabled() const;
+  void cancel();
+};
+
+}
+
+#endif
@@ -26,6 +26,8 @@
 #include <signal.h>
 #include <sys/time.h>
 #include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
 #include <time.h>
 #include <string.h>
 #include <assert.h>
@@ -36,67 +38,72 @@
 #include "gtkinterface.h"
 #include "options.h"
 #include "playlist.h"
+#include "playlistloader.h"
+#include "uriresolver.h"
+#include "library.h"
+#include "discovery.h"
 #include "visualization.h"
 #include "msg.h"
 #include "typefinder.h"
 #include "utils.h"
+#include "render.h"
+#include "batch.h"
+#include "tags.h"
+#include "profiler.h"
+#include "qos.h"
+#include "statusline.h"
+#include "statusstream.h"
+#include "metrics.h"
+#include "trackswitch.h"
+#include "startuptrace.h"
 #include <vector>
 #include <string>
 #include <list>
 #include <iostream>
+#include <atomic>
+#include <algorithm>
 
 using std::string;
 using std::vector;
 using std::list;
 using std::swap;
+using std::map;
 
 using namespace Gst123;
 
 static Terminal     terminal;
 static GtkInterface gtk_interface;
+static Render       render;
+static ElementProfiler profiler;
+static StatusStream status_stream;
+static TrackSwitchStats track_switch;
 
 /* playbin flags */
 enum GstPlayFlags {
   GST_PLAY_FLAG_VIDEO = (1 << 0),
   GST_PLAY_FLAG_AUDIO = (1 << 1),
-  GST_PLAY_FLAG_TEXT  = (1 << 2)
-};
-
-struct Tags
-{
-  double timestamp;
-  string title;
-  string artist;
-  string album;
-  string date;
-  string comment;
-  string genre;
-  string codec;
-  string vcodec;
-  guint bitrate;
-
-  Tags() : timestamp (-1), bitrate (0)
-  {
-  }
+  GST_PLAY_FLAG_TEXT  = (1 << 2),
+  GST_PLAY_FLAG_VIS   = (1 << 3)
 };
 
 static int
 get_columns()
 {
-  int   result = 80; /* default */
+  int fds[] = { STDOUT_FILENO, STDIN_FILENO, STDERR_FILENO };
 
-  FILE *cols = popen ("tput cols", "r");
-  char  col_buffer[50];
-  char *line = fgets (col_buffer, 50, cols);
-  if (line)
+  for (size_t i = 0; i < G_N_ELEMENTS (fds); i++)
     {
-      int c = atoi (col_buffer);
-      if (c > 30)
-        result = c;
+      struct winsize ws;
+
+      if (ioctl (fds[i], TIOCGWINSZ, &ws) == 0 && ws.ws_col > 30)
+        return ws.ws_col;
     }
-  pclose (cols);
 
-  return result;
+  const char *columns = g_getenv ("COLUMNS");
+  if (columns && atoi (columns) > 30)
+    return atoi (columns);
+
+  return 80; /* default */
 }
 
 static string
@@ -123,25 +130,6 @@ aspect_iterfunc (const GValue *evalue, gpointer userdata)
   force_aspect_ratio (element);
 }
 
-static bool
-filename2uri (string& uri)
-{
-  GError *err = NULL;
-
-  char *xuri = g_filename_to_uri (uri.c_str(), NULL, &err);
-  uri = xuri;
-  g_free (xuri);
-
-  if (err != NULL)
-    {
-      g_critical ("Unable to convert to URI: %s", err->message);
-      g_error_free (err);
-
-      return false;
-    }
-  return true;
-}
-
 static string
 uri2filename (const string& uri)
 {
@@ -175,9 +163,34 @@ struct Chapter
   string title;
 };
 
-struct Player : public KeyHandler
+static gboolean cb_print_position (gpointer *data);
+static gboolean cb_status_position (gpointer *data);
+static gboolean cb_display_tags (gpointer *data);
+static vector<string> crawl (const string& path);
+
+struct Player : public KeyHandler, public PlaylistLoader::Handler, public Discovery::Handler
 {
   vector<string> uris;
+  map<string, PlaylistEntry> playlist_info;   // duration/title from playlist files or discovery, indexed by uri
+  Discovery      discovery;
+
+  /* running totals of the durations of the entries in uris, so that
+   * print_playlist_info() doesn't need to scan the whole playlist for every
+   * track; "played" counts the entries before played_pos
+   */
+  struct DurationRefs
+  {
+    int refs;          // number of entries with this uri
+    int played_refs;   // ... before played_pos
+
+    DurationRefs() : refs (0), played_refs (0) {}
+  };
+  map<string, DurationRefs> duration_refs;
+  double         total_duration;
+  int            total_unknown;     // entries without known duration
+  double         played_duration;
+  int            played_unknown;
+  guint          played_pos;
 
   GstElement   *playbin;
   GMainLoop    *loop;
@@ -185,12 +198,44 @@ struct Player : public KeyHandler
   guint         play_position;
   int           cols;
   Tags          tags;
+  QosStats      qos;
   GstState      last_state;
   string        old_tag_chapter_str;
 
+  StatusLine    status_line;
+  guint         status_timeout_id;
+  guint         status_interval;
+  guint         tags_timeout_id;
+  guint         status_position_id;   // --status-fd position events, only while playing
+  bool          stdout_is_tty;
+  std::atomic<bool> muted;          // updated by notify::mute, which may occur in any thread
+
+  double        seek_start_time;    // for seek latency metrics, 0 if no seek is pending
+
   double        playback_rate;
   double        playback_rate_step;
 
+  string        segment_uri;        // file of the current virtual track (cue sheet), "" for normal tracks
+  gint64        segment_start;
+  gint64        segment_end;        // -1 if the virtual track ends with the file
+  bool          segment_seamless;   // switch to the next virtual track without flushing
+  bool          cue_chapters;       // chapters are the virtual tracks of the current file
+
+  bool          lazy;               // entries are checked when they are played (--lazy)
+  map<string, string> lazy_cue_files;   // --lazy: cue sheet files which were resolved (path -> uri)
+  bool          playlist_loading;   // playlists are still being parsed in the background
+  bool          playlist_waiting;   // play_next() is waiting for more playlist entries
+  int           exit_status;
+
+  bool          track_finished;
+  enum RenderFinish { FINISH_NONE, FINISH_NEXT, FINISH_QUIT };
+  RenderFinish  render_finishing;   // waiting for EOS of the rendered track, then play next/quit
+  guint         render_finish_timeout_id;
+  GMutex        gapless_mutex;
+  string        gapless_uri;        // protected by gapless_mutex
+  guint         gapless_position;   // protected by gapless_mutex
+  bool          gapless_started;    // protected by gapless_mutex
+
   enum
   {
     KEEP_CODEC_TAGS,
@@ -216,30 +261,223 @@ struct Player : public KeyHandler
   }
 
   void
-  add_uri (string uri)
+  add_uri (string uri, const PlaylistEntry *info = NULL)
   {
-    if (!gst_uri_is_valid (uri.c_str()))
+    if (!lazy)
       {
-	if (!g_path_is_absolute (uri.c_str()))
-	  uri = g_get_current_dir() + string (G_DIR_SEPARATOR + uri);
-
-        if (!filename2uri (uri))
-          return;
+        uri = UriResolver::to_uri (uri);
+      }
+    else if (info && info->start >= 0)
+      {
+        /* more virtual tracks of a file which has already been resolved */
+        map<string, string>::const_iterator ci = lazy_cue_files.find (uri);
+        if (ci != lazy_cue_files.end())
+          uri = ci->second;
       }
+
+    if (info && info->start >= 0)
+      uri += time_fragment (info->start, info->end);
     uris.push_back (uri);
+
+    if (!(info && info->start >= 0))      // virtual tracks don't need to be probed
+      discovery.add (uri);
+
+    if (info && (info->duration > 0 || info->title != "" || info->start >= 0))
+      {
+        double old_duration = entry_duration (uri);
+        playlist_info[uri] = *info;
+        playlist_info[uri].location = uri;
+        duration_changed (uri, old_duration);
+      }
+    count_entry (uri, 1, false);
+  }
+
+  double
+  entry_duration (const string& uri)
+  {
+    const PlaylistEntry *info = find_playlist_info (uri);
+    return (info && info->duration > 0) ? info->duration : -1;
   }
 
+  static void
+  add_duration (double duration, int n, double& sum, int& unknown)
+  {
+    if (duration > 0)
+      sum += n * duration;
+    else
+      unknown += n;
+  }
+
+  /* adds (n > 0) or removes (n < 0) entries of uri to/from the running totals */
   void
-  set_subtitle (string uri)
+  count_entry (const string& uri, int n, bool played)
   {
-    if (!gst_uri_is_valid (uri.c_str()))
+    DurationRefs& dr = duration_refs[uri];
+    double duration = entry_duration (uri);
+
+    dr.refs += n;
+    add_duration (duration, n, total_duration, total_unknown);
+    if (played)
       {
-        if (!g_path_is_absolute (uri.c_str()))
-          uri = g_get_current_dir() + string (G_DIR_SEPARATOR + uri);
+        dr.played_refs += n;
+        add_duration (duration, n, played_duration, played_unknown);
+      }
+    if (dr.refs == 0)
+      duration_refs.erase (uri);
+  }
 
-        if (!filename2uri (uri))
-          return;
+  /* updates the running totals after the duration of uri changed */
+  void
+  duration_changed (const string& uri, double old_duration)
+  {
+    double new_duration = entry_duration (uri);
+    map<string, DurationRefs>::const_iterator di = duration_refs.find (uri);
+    if (new_duration == old_duration || di == duration_refs.end())
+      return;
+
+    add_duration (old_duration, -di->second.refs, total_duration, total_unknown);
+    add_duration (new_duration, di->second.refs, total_duration, total_unknown);
+    add_duration (old_duration, -di->second.played_refs, played_duration, played_unknown);
+    add_duration (new_duration, di->second.played_refs, played_duration, played_unknown);
+  }
+
+  /* call these before the entries of uris are changed */
+  void
+  reset_played()
+  {
+    for (guint i = 0; i < played_pos; i++)
+      duration_refs[uris[i]].played_refs--;
+
+    played_duration = 0;
+    played_unknown = 0;
+    played_pos = 0;
+  }
+
+  void
+  erase_entry_durations (guint pos)
+  {
+    bool played = pos < played_pos;
+
+    count_entry (uris[pos], -1, played);
+    if (played)
+      played_pos--;
+  }
+
+  /* virtual tracks (cue sheets) are stored as <file uri>#t=<start>[,<end>]
+   * (this is the temporal media fragment syntax)
+   */
+  static string
+  time_fragment (double start, double end)
+  {
+    if (end >= 0)
+      return string_printf ("#t=%.3f,%.3f", start, end);
+    return string_printf ("#t=%.3f", start);
+  }
+
+  static bool
+  split_time_fragment (const string& uri, string& media_uri, gint64& start, gint64& end)
+  {
+    size_t pos = uri.rfind ("#t=");
+    if (pos == string::npos)
+      {
+        media_uri = uri;
+        return false;
+      }
+    media_uri = uri.substr (0, pos);
+
+    const char *times = uri.c_str() + pos + 3;
+    char *comma;
+    start = g_ascii_strtod (times, &comma) * GST_SECOND;
+    end = (*comma == ',') ? gint64 (g_ascii_strtod (comma + 1, NULL) * GST_SECOND) : -1;
+    return true;
+  }
+
+  static string
+  media_uri (const string& uri)
+  {
+    string result;
+    gint64 start, end;
+    split_time_fragment (uri, result, start, end);
+    return result;
+  }
+
+  /* for batch modes, which can't play virtual tracks */
+  vector<string>
+  media_uris()
+  {
+    vector<string> result;
+    for (vector<string>::const_iterator ui = uris.begin(); ui != uris.end(); ui++)
+      {
+        string uri = media_uri (*ui);
+        if (result.empty() || result.back() != uri)
+          result.push_back (uri);
       }
+    return result;
+  }
+
+  const PlaylistEntry *
+  find_playlist_info (const string& uri)
+  {
+    map<string, PlaylistEntry>::const_iterator pi = playlist_info.find (uri);
+    if (pi != playlist_info.end())
+      return &pi->second;
+    return NULL;
+  }
+
+  static string
+  format_duration (double seconds)
+  {
+    guint sec = seconds + 0.5;
+    guint min = sec / 60;
+    if (min >= 60)
+      return string_printf ("%u:%02u:%02u", min / 60, min % 60, sec % 60);
+    return string_printf ("%u:%02u", min, sec % 60);
+  }
+
+  /* print what the playlist files (or the discovery) told us about the track
+   * at index pos, as well as the total and remaining playlist time; this is
+   * available before the files are played
+   */
+  void
+  print_playlist_info (guint pos)
+  {
+    if (playlist_info.empty() || pos >= uris.size())
+      return;
+
+    string line = string_printf ("Track %u/%zu", pos + 1, uris.size());
+
+    const PlaylistEntry *info = find_playlist_info (uris[pos]);
+    if (info && info->title != "")
+      line += ": " + info->title;
+    if (info && info->duration > 0)
+      line += " [" + format_duration (info->duration) + "]";
+
+    /* usually we play the next entry, so this only needs to count one more entry */
+    if (pos < played_pos)
+      reset_played();
+    for (; played_pos < pos; played_pos++)
+      {
+        duration_refs[uris[played_pos]].played_refs++;
+        add_duration (entry_duration (uris[played_pos]), 1, played_duration, played_unknown);
+      }
+
+    double total = total_duration;
+    double remaining = std::max (total_duration - played_duration, 0.0);
+    bool   total_complete = !playlist_loading && total_unknown == 0;
+    bool   remaining_complete = !playlist_loading && total_unknown == played_unknown;
+    /* for tracks without duration we don't know the real total, so we print a lower bound */
+    if (total > 0)
+      line += string_printf (" | Total: %s%s | Remaining: %s%s",
+                             total_complete ? "" : ">", format_duration (total).c_str(),
+                             remaining_complete ? "" : ">", format_duration (remaining).c_str());
+
+    Msg::print ("%s\n", line.c_str());
+  }
+
+  void
+  set_subtitle (string uri)
+  {
+    uri = UriResolver::to_uri (uri);
     g_object_set (G_OBJECT (playbin), "suburi", uri.c_str(), NULL);
   }
 
@@ -297,6 +535,57 @@ struct Player : public KeyHandler
     return chapter_str;
   }
 
+  void
+  send_track_event (guint index, const string& uri)
+  {
+    const PlaylistEntry *info = find_playlist_info (uri);
+
+    string fields = string_printf ("\"index\":%u,\"uri\":%s", index, json_string (uri).c_str());
+    if (info && info->title != "")
+      fields += ",\"title\":" + json_string (info->title);
+    if (info && info->duration > 0)
+      fields += string_printf (",\"duration\":%.3f", info->duration);
+    status_stream.send ("track", fields);
+  }
+
+  void
+  send_tags_event()
+  {
+    if (!status_stream.enabled())
+      return;
+
+    string fields = string_printf ("\"title\":%s,\"artist\":%s,\"album\":%s,\"genre\":%s,\"date\":%s,\"comment\":%s,"
+                                   "\"codec\":%s,\"vcodec\":%s,\"bitrate\":%u,\"chapters\":[",
+                                   json_string (tags.title).c_str(), json_string (tags.artist).c_str(),
+                                   json_string (tags.album).c_str(), json_string (tags.genre).c_str(),
+                                   json_string (tags.date).c_str(), json_string (tags.comment).c_str(),
+                                   json_string (tags.codec).c_str(), json_string (tags.vcodec).c_str(), tags.bitrate);
+    for (size_t i = 0; i < chapters.size(); i++)
+      {
+        fields += string_printf ("%s{\"start\":%.3f,\"title\":%s}", i ? "," : "",
+                                 chapters[i].start_time / double (GST_SECOND), json_string (chapters[i].title).c_str());
+      }
+    fields += "]";
+    status_stream.send ("tags", fields);
+  }
+
+  void
+  send_position_event()
+  {
+    gint64 pos, len;
+
+    if (last_state != GST_STATE_PLAYING ||
+        !gst_element_query_position (playbin, GST_FORMAT_TIME, &pos) ||
+        !gst_element_query_duration (playbin, GST_FORMAT_TIME, &len))
+      return;
+
+    /* streams (i.e. http) have len == -1 */
+    status_stream.send ("position", string_printf ("\"position\":%.3f,\"duration\":%s,\"rate\":%.3f",
+                                                   pos / double (GST_SECOND),
+                                                   len > 0 ? string_printf ("%.3f", len / double (GST_SECOND)).c_str() : "null",
+                                                   playback_rate));
+  }
+
   void
   display_tags_and_chapters()
   {
@@ -310,6 +599,8 @@ struct Player : public KeyHandler
 	      overwrite_time_display();
 	      Msg::print ("\n%s\n", tag_chapter_str.c_str());
               old_tag_chapter_str = tag_chapter_str;
+
+              send_tags_event();
             }
 
           /* older gst123 versions use reset_tags (KEEP_CODEC_TAGS); here, but for some
@@ -321,9 +612,228 @@ struct Player : public KeyHandler
   void
   overwrite_time_display()
   {
-    for (int i = 0; i < cols; i++)
-      Msg::print (" ");
-    Msg::print ("\r");
+    status_line.clear();
+  }
+
+  bool
+  status_enabled()
+  {
+    /* without a terminal to show it, there is no point in updating the status line */
+    return !options.quiet && stdout_is_tty;
+  }
+
+  guint
+  wanted_status_interval()
+  {
+    /* while paused, the position doesn't change; a slow tick is enough for status messages */
+    return (last_state == GST_STATE_PLAYING) ? 130 : 1000;
+  }
+
+  void
+  schedule_status_update()
+  {
+    if (!status_enabled())
+      return;
+
+    guint interval = wanted_status_interval();
+
+    if (status_timeout_id && interval == status_interval)
+      return;
+
+    if (status_timeout_id)
+      g_source_remove (status_timeout_id);
+
+    status_interval = interval;
+    if (interval % 1000 == 0)  /* allows glib to coalesce wakeups with other timers */
+      status_timeout_id = g_timeout_add_seconds (interval / 1000, (GSourceFunc) cb_print_position, this);
+    else
+      status_timeout_id = g_timeout_add (interval, (GSourceFunc) cb_print_position, this);
+  }
+
+  void
+  schedule_position_events()
+  {
+    /* the position doesn't change unless we're playing */
+    bool wanted = status_stream.enabled() && last_state == GST_STATE_PLAYING;
+
+    if (wanted && !status_position_id)
+      status_position_id = g_timeout_add_seconds (1, (GSourceFunc) cb_status_position, this);
+    if (!wanted && status_position_id)
+      {
+        g_source_remove (status_position_id);
+        status_position_id = 0;
+      }
+  }
+
+  void
+  schedule_tags_display()
+  {
+    /* without status timer, tags need to be displayed by a one-shot timer */
+    if (status_timeout_id || tags_timeout_id)
+      return;
+
+    tags_timeout_id = g_timeout_add (600, (GSourceFunc) cb_display_tags, this);
+  }
+
+  void
+  update_status_line()
+  {
+    gint64 pos, len;
+
+    display_tags_and_chapters();
+
+    if (!status_enabled())
+      return;
+
+    if (!gst_element_query_position (playbin, GST_FORMAT_TIME, &pos))
+      return;
+
+    if (!gst_element_query_duration (playbin, GST_FORMAT_TIME, &len) || len <= 0)
+      {
+        /* use the duration from the playlist file (if any) until the stream knows its duration */
+        const PlaylistEntry *info = play_position > 0 ? find_playlist_info (uris[play_position - 1]) : NULL;
+        len = (info && info->duration > 0) ? gint64 (info->duration * GST_SECOND) : -1;
+      }
+    if (segment_uri != "")
+      {
+        /* virtual track: show the time relative to the track, not to the file */
+        if (len > 0)
+          len = (segment_end >= 0 ? segment_end : len) - segment_start;
+        pos = MAX (pos - segment_start, 0);
+      }
+
+    guint pos_ms = (pos % GST_SECOND) / 1000000;
+    guint len_ms = (len % GST_SECOND) / 1000000;
+    guint pos_sec = pos / GST_SECOND;
+    guint len_sec = len / GST_SECOND;
+    guint pos_min = pos_sec / 60;
+    guint len_min = len_sec / 60;
+
+    string line = string_printf ("Time: %01u:%02u:%02u.%02u", pos_min / 60, pos_min % 60, pos_sec % 60, pos_ms / 10);
+    if (len > 0)   /* streams (i.e. http) have len == -1 */
+      line += string_printf (" of %01u:%02u:%02u.%02u", len_min / 60, len_min % 60, len_sec % 60, len_ms / 10);
+
+    string message = Msg::status();
+    if (message != "")
+      {
+        line += " | " + message;
+      }
+    else if (qos.total_dropped() > 0)
+      {
+        /* dropped frames are more important than the bitrate */
+        line += " | " + qos.format_status();
+      }
+    else
+      {
+        /* only print bitrate if no status message needs to be shown, in
+         * order to avoid too long output lines
+         */
+        if (tags.bitrate > 0)
+          line += string_printf (" | Bitrate: %.1f kbit/sec", tags.bitrate / 1000.);
+      }
+
+    if (muted)
+      line += " [MUTED]";
+
+    if (last_state == GST_STATE_PAUSED)
+      line += " [PAUSED]";
+
+    status_line.update (line);
+  }
+
+  /* with --lazy, entries are stored unchecked and converted to uris when
+   * they are played; returns false if the entry was removed (missing file)
+   * or replaced (by the files of a directory)
+   */
+  bool
+  resolve_entry (guint pos)
+  {
+    const string entry = uris[pos];
+    if (UriResolver::has_scheme (entry))
+      return true;
+
+    string path = entry, fragment;
+    size_t fragment_pos = entry.rfind ("#t=");   // virtual track, see time_fragment()
+    if (fragment_pos != string::npos)
+      {
+        path = entry.substr (0, fragment_pos);
+        fragment = entry.substr (fragment_pos);
+      }
+    path = UriResolver::absolute_path (path);
+
+    FileInfo finfo = UriResolver::file_info (path);
+    if (finfo == FI_ERROR)
+      {
+        overwrite_time_display();
+        Msg::print ("\nSkipping missing file %s\n", path.c_str());
+
+        erase_entry_durations (pos);
+        uris.erase (uris.begin() + pos);
+        if (!duration_refs.count (entry))
+          playlist_info.erase (entry);
+        return false;
+      }
+    if (finfo == FI_DIR)
+      {
+        vector<string> files = crawl (path);
+        for (vector<string>::iterator fi = files.begin(); fi != files.end(); fi++)
+          *fi = UriResolver::file_uri (*fi);
+
+        if (pos < played_pos)
+          reset_played();
+        erase_entry_durations (pos);
+        uris.erase (uris.begin() + pos);
+        uris.insert (uris.begin() + pos, files.begin(), files.end());
+        for (vector<string>::iterator fi = files.begin(); fi != files.end(); fi++)
+          count_entry (*fi, 1, false);
+        return false;
+      }
+
+    string file_uri = UriResolver::file_uri (path);
+    set_entry_uri (pos, file_uri + fragment);
+    if (fragment == "")
+      {
+        discovery.add (file_uri);
+      }
+    else
+      {
+        /* set_cue_chapters() and segment_done() find the other virtual tracks
+         * of the file by its uri, so these need to be resolved, too
+         */
+        lazy_cue_files[entry.substr (0, fragment_pos)] = file_uri;
+
+        string prefix = entry.substr (0, fragment_pos) + "#t=";
+        for (guint i = 0; i < uris.size(); i++)
+          {
+            if (uris[i].compare (0, prefix.size(), prefix) == 0)
+              set_entry_uri (i, file_uri + uris[i].substr (fragment_pos));
+          }
+      }
+    return true;
+  }
+
+  void
+  set_entry_uri (guint pos, const string& uri)
+  {
+    bool played = pos < played_pos;
+
+    count_entry (uris[pos], -1, played);
+
+    map<string, PlaylistEntry>::iterator pi = playlist_info.find (uris[pos]);
+    if (pi != playlist_info.end())
+      {
+        PlaylistEntry info = pi->second;
+        info.location = uri;
+        if (!duration_refs.count (uris[pos]))
+          playlist_info.erase (pi);
+
+        double old_duration = entry_duration (uri);
+        playlist_info[uri] = info;
+        duration_changed (uri, old_duration);
+      }
+    uris[pos] = uri;
+
+    count_entry (uri, 1, played);
   }
 
   void
@@ -332,11 +842,13 @@ struct Player : public KeyHandler
     assert (play_position > 0);
 
     play_position--;
+    erase_entry_durations (play_position);
     uris.erase (uris.begin() + play_position);
   }
 
-  bool
-  is_image_file (const string& uri)
+  /* "audio", "video", "image", ... for local files, "" if unknown */
+  string
+  media_type (const string& uri)
   {
     if (uri.substr (0, 5) == "file:")
       {
@@ -345,11 +857,64 @@ struct Player : public KeyHandler
         if (filename != "")
           {
             TypeFinder tf (filename);
-            if (tf.type() == "image")
-              return true;
+            return tf.type();
           }
       }
-    return false;
+    return "";
+  }
+
+  bool
+  is_image_file (const string& uri)
+  {
+    return media_type (uri) == "image";
+  }
+
+  /* the video sink needs the window as soon as it starts, so for tracks which
+   * (may) have video we initialize the display before playing them; if it
+   * can't be used, we only play the audio (like --novideo)
+   */
+  void
+  prepare_video_output (const string& type)
+  {
+    int flags;
+    g_object_get (playbin, "flags", &flags, NULL);
+
+    if (!(flags & GST_PLAY_FLAG_VIDEO))
+      return;
+    if (type == "audio" && !(flags & GST_PLAY_FLAG_VIS))
+      return;
+    if (type == "" && !(flags & GST_PLAY_FLAG_VIS))
+      return;   // streams: initialized by cb_init_display() once the sink asks for a window
+
+    if (!gtk_interface.init_display())
+      disable_video();
+  }
+
+  void
+  disable_video()
+  {
+    int flags;
+    g_object_get (playbin, "flags", &flags, NULL);
+    g_object_set (playbin, "flags", flags & ~(GST_PLAY_FLAG_VIDEO | GST_PLAY_FLAG_VIS), NULL);
+  }
+
+  /* a video sink failed, maybe because the display can't be used: then the
+   * track is played again without video instead of being removed
+   */
+  bool
+  retry_without_video()
+  {
+    int flags;
+    g_object_get (playbin, "flags", &flags, NULL);
+
+    if (!(flags & GST_PLAY_FLAG_VIDEO) || play_position == 0 || gtk_interface.init_display())
+      return false;
+
+    g_print ("=> display can't be used, playing without video\n\n");
+    disable_video();
+    play_position--;
+    play_next();
+    return true;
   }
 
   // decode filename from uri to normal string
@@ -376,14 +941,217 @@ struct Player : public KeyHandler
     return ret;
   }
 
+  /* the encoder needs to see EOS to write a valid file header: if the rendered
+   * track is interrupted, this sends EOS and returns true; the bus callback
+   * continues with play_next() or quit() (depending on action) once the EOS
+   * arrived, so the main loop isn't blocked meanwhile
+   */
+  bool
+  finish_render_track (RenderFinish action)
+  {
+    if (render_finishing != FINISH_NONE)
+      {
+        if (action == FINISH_QUIT)
+          render_finishing = FINISH_QUIT;
+        return true;
+      }
+    if (render.enabled() && !track_finished && last_state >= GST_STATE_PAUSED)
+      {
+        render_finishing = action;
+        gst_element_send_event (playbin, gst_event_new_eos());
+
+        /* don't wait forever if the pipeline doesn't handle the EOS */
+        render_finish_timeout_id = g_timeout_add_seconds (5, cb_render_finish_timeout, this);
+        return true;
+      }
+    track_finished = true;
+    return false;
+  }
+
+  /* called on EOS (or error, or timeout) after finish_render_track() */
+  void
+  render_track_finished()
+  {
+    if (render_finish_timeout_id)
+      {
+        g_source_remove (render_finish_timeout_id);
+        render_finish_timeout_id = 0;
+      }
+    RenderFinish action = render_finishing;
+    render_finishing = FINISH_NONE;
+    track_finished = true;
+
+    if (action == FINISH_QUIT)
+      quit();
+    else
+      play_next();
+  }
+
+  static gboolean
+  cb_render_finish_timeout (gpointer data)
+  {
+    Player *player = static_cast<Player *> (data);
+
+    player->render_finish_timeout_id = 0;
+    player->render_track_finished();
+    return FALSE;
+  }
+
+  bool
+  render_gapless()
+  {
+    return render.enabled() && !render.per_track();
+  }
+
+  /* when rendering into one file, the pipeline (and with it the output file)
+   * must never be reset: playbin would reopen and truncate the file; this is
+   * only possible for normal files (switched by about-to-finish) or for the
+   * virtual tracks of one file (switched by seeking)
+   */
+  bool
+  check_render_gapless (string& error)
+  {
+    string virtual_file;
+    bool   have_files = false;
+
+    for (vector<string>::const_iterator ui = uris.begin(); ui != uris.end(); ui++)
+      {
+        string file;
+        gint64 start, end;
+        if (!split_time_fragment (*ui, file, start, end))
+          have_files = true;
+        else if (virtual_file == "")
+          virtual_file = file;
+        else if (file != virtual_file)
+          {
+            error = "can't render the tracks of more than one cue sheet into one file (use %n or %b in the filename)";
+            return false;
+          }
+      }
+    if (virtual_file != "" && have_files)
+      {
+        error = "can't render the tracks of a cue sheet together with other files into one file (use %n or %b in the filename)";
+        return false;
+      }
+    if (options.repeat)
+      {
+        error = "--repeat can't be used when rendering into one file";
+        return false;
+      }
+    return true;
+  }
+
+  /* when rendering into one file, playbin's about-to-finish signal is used to
+   * switch to the next track without gap (and without resetting the output)
+   */
+  void
+  prepare_gapless()
+  {
+    guint pos = play_position;
+    while (pos < uris.size())
+      {
+        if (lazy && !resolve_entry (pos))
+          continue;
+        if (!is_image_file (media_uri (uris[pos])))
+          break;
+        pos++;
+      }
+
+    g_mutex_lock (&gapless_mutex);
+    if (pos < uris.size() && media_uri (uris[pos]) == uris[pos])  // virtual tracks are played by play_next()
+      {
+        gapless_uri = uris[pos];
+        gapless_position = pos;
+      }
+    else
+      {
+        gapless_uri = "";
+      }
+    gapless_started = false;
+    g_mutex_unlock (&gapless_mutex);
+  }
+
+  void
+  gapless_stream_start()
+  {
+    g_mutex_lock (&gapless_mutex);
+    bool  started = gapless_started;
+    guint pos = gapless_position;
+    gapless_started = false;
+    g_mutex_unlock (&gapless_mutex);
+
+    if (started && pos < uris.size())
+      {
+        play_position = pos + 1;
+        reset_tags (RESET_ALL_TAGS);
+        chapters.clear();
+
+        overwrite_time_display();
+        Msg::print ("\nPlaying %s\n", url_decode (uris[pos]).c_str());
+        print_playlist_info (pos);
+        send_track_event (pos + 1, uris[pos]);
+        Metrics::the().tracks_played.inc();
+
+        prepare_gapless();
+      }
+  }
+
+  void
+  print_qos_summary()
+  {
+    if (qos.have_data())
+      {
+        overwrite_time_display();
+        Msg::print ("\n%s\n", qos.format_summary().c_str());
+      }
+    qos.reset();
+  }
+
+  void
+  check_qos_warning()
+  {
+    /* we need some frames before the percentage is meaningful */
+    const guint64 min_frames = 100;
+
+    if (options.qos_warn > 0 && !qos.warned &&
+        qos.total_processed() + qos.total_dropped() >= min_frames &&
+        qos.dropped_percent() > options.qos_warn)
+      {
+        overwrite_time_display();
+        g_printerr ("\nWarning: %.1f%% of the video frames were dropped (threshold %.1f%%), decoding is too slow\n",
+                    qos.dropped_percent(), options.qos_warn);
+        qos.warned = true;
+      }
+  }
+
   void
   play_next()
   {
+    if (finish_render_track (FINISH_NEXT))
+      return;   // continued once the rendered track is finished
+
+    track_switch.start();
+    print_qos_summary();
     reset_tags (RESET_ALL_TAGS);
     chapters.clear();
+    cue_chapters = false;
+
+    bool seamless = segment_seamless;
+    segment_seamless = false;
+
+    g_mutex_lock (&gapless_mutex);
+    gapless_uri = "";
+    gapless_started = false;
+    g_mutex_unlock (&gapless_mutex);
 
     for (;;)
       {
+        if (playlist_loading && (play_position == uris.size() || options.shuffle))
+          {
+            /* continue once more entries are parsed; shuffling needs the complete list */
+            playlist_waiting = true;
+            return;
+          }
         if (play_position == uris.size() && options.repeat)
           {
             if (uris.empty())
@@ -396,20 +1164,30 @@ struct Player : public KeyHandler
         if (options.shuffle && play_position == 0)
           {
             // Fisher–Yates shuffle
+            reset_played();
             for (guint i = 0; i < uris.size(); i++)
               {
                 guint j = g_random_int_range (i, uris.size());
                 swap (uris[i], uris[j]);
               }
           }
+        if (lazy && play_position < uris.size() && !resolve_entry (play_position))
+          continue;
         if (play_position < uris.size())
           {
             string uri = uris[play_position++];
 
-            cols = get_columns();
             overwrite_time_display();
 
-            if (is_image_file (uri))
+            string file_uri;
+            gint64 start, end;
+            bool   is_virtual = split_time_fragment (uri, file_uri, start, end);
+
+            string type = media_type (file_uri);
+            bool   is_image = (type == "image");
+            track_switch.mark (TrackSwitchStats::TYPE_DETECTION);
+
+            if (is_image)
               {
                 Msg::print ("\nSkipping image %s\n", uri.c_str());
 
@@ -417,28 +1195,72 @@ struct Player : public KeyHandler
               }
             else
               {
-                Msg::print ("\nPlaying %s\n", url_decode (uri).c_str());
+                Msg::print ("\nPlaying %s\n", url_decode (file_uri).c_str());
+                print_playlist_info (play_position - 1);
+                send_track_event (play_position, uri);
+
+                Metrics::the().tracks_played.inc();
+                seek_start_time = 0;
+
+                const PlaylistEntry *info = find_playlist_info (uri);
+                gtk_interface.set_title ((info && info->title != "") ? info->title : get_basename (file_uri));
 
-                gtk_interface.set_title (get_basename (uri));
+                if (is_virtual)
+                  set_cue_chapters (file_uri);
+
+                /* the next virtual track of the file which is already playing: just seek;
+                 * when rendering into one file, the output must not be reset, so the
+                 * seek never flushes (the segment of the previous track is done anyway)
+                 */
+                if (is_virtual && file_uri == segment_uri && (!render.enabled() || render_gapless()) &&
+                    last_state >= GST_STATE_PAUSED)
+                  {
+                    segment_start = start;
+                    segment_end = end;
+                    seek_segment (start, (seamless || render_gapless()) ? GST_SEEK_FLAG_NONE : GST_SEEK_FLAG_FLUSH);
+                    return; // -> done
+                  }
+                segment_uri = "";
 
                 gst_element_set_state (playbin, GST_STATE_NULL);
-                g_object_set (G_OBJECT (playbin), "uri", uri.c_str(), NULL);
+                track_switch.mark (TrackSwitchStats::TEARDOWN);
+                if (render.enabled())
+                  {
+                    string location = render.set_track (play_position, uri);
+                    if (render.per_track())
+                      Msg::print ("Writing %s\n", location.c_str());
+                  }
+                prepare_video_output (type);
+                g_object_set (G_OBJECT (playbin), "uri", file_uri.c_str(), NULL);
                 if (!options.subtitle)
                   {
-                    string suburi = guess_subtitle (uri);
+                    string suburi = guess_subtitle (file_uri);
                     if (!suburi.empty())
                       g_object_set (G_OBJECT (playbin), "suburi", suburi.c_str(), NULL);
                     else
                       g_object_set (G_OBJECT (playbin), "suburi", NULL, NULL);
                   }
+                track_switch.mark (TrackSwitchStats::URI_SET);
                 gst_element_set_state (playbin, GST_STATE_PLAYING);
+                track_finished = false;
 
+                if (is_virtual)
+                  {
+                    // block until state changed and seek to the start of the virtual track
+                    gst_element_get_state (playbin, NULL, NULL, GST_CLOCK_TIME_NONE);
+                    segment_uri = file_uri;
+                    segment_start = start;
+                    segment_end = end;
+                    seek_segment (start, GST_SEEK_FLAG_FLUSH);
+                  }
                 if (options.skip > 0)
                   {
                     // block until state changed and seek to skip position
                     gst_element_get_state (playbin, NULL, NULL, GST_CLOCK_TIME_NONE);
                     seek (options.skip * GST_SECOND);
                   }
+                if (render_gapless())
+                  prepare_gapless();
                 return; // -> done
               }
           }
@@ -481,6 +1303,12 @@ struct Player : public KeyHandler
     // * seek position: multiply with GST_SECOND to convert seconds to nanoseconds or with
     //   GST_MSECOND to convert milliseconds to nanoseconds.
 
+    if (segment_uri != "")
+      {
+        seek_segment (new_pos, GST_SEEK_FLAG_FLUSH);
+        return;
+      }
+
     if (new_pos < 0)
       new_pos = 0;
 
@@ -500,8 +1328,81 @@ struct Player : public KeyHandler
         start_pos = 0;
         stop_pos = new_pos;
       }
-    gst_element_seek (playbin, playback_rate, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH,
-                      GST_SEEK_TYPE_SET, start_pos, GST_SEEK_TYPE_SET, stop_pos);
+    if (gst_element_seek (playbin, playback_rate, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH,
+                          GST_SEEK_TYPE_SET, start_pos, GST_SEEK_TYPE_SET, stop_pos))
+      seek_start_time = get_time();
+  }
+
+  /* seek within the current virtual track; the segment flag makes the
+   * pipeline post SEGMENT_DONE instead of EOS at the end of the track
+   */
+  void
+  seek_segment (gint64 new_pos, GstSeekFlags flags)
+  {
+    if (segment_end >= 0 && new_pos >= segment_end)
+      {
+        play_next();
+        return;
+      }
+    if (new_pos < segment_start)
+      new_pos = segment_start;
+
+    gint64 start_pos;
+    gint64 stop_pos;
+    if (playback_rate >= 0)
+      {
+        start_pos = new_pos;
+        stop_pos = segment_end >= 0 ? segment_end : GST_CLOCK_TIME_NONE;
+      }
+    else
+      {
+        // when playing in reverse it is from stop to start
+        start_pos = segment_start;
+        stop_pos = new_pos;
+      }
+    if (gst_element_seek (playbin, playback_rate, GST_FORMAT_TIME, GstSeekFlags (flags | GST_SEEK_FLAG_SEGMENT | GST_SEEK_FLAG_ACCURATE),
+                          GST_SEEK_TYPE_SET, start_pos, GST_SEEK_TYPE_SET, stop_pos))
+      seek_start_time = get_time();
+  }
+
+  /* end of a virtual track: if the next virtual track continues in the same
+   * file, a non-flushing seek makes the transition gapless
+   */
+  void
+  segment_done()
+  {
+    if (play_position < uris.size())
+      {
+        string next_uri;
+        gint64 next_start, next_end;
+        if (split_time_fragment (uris[play_position], next_uri, next_start, next_end) &&
+            next_uri == segment_uri && ABS (next_start - segment_end) < 10 * GST_MSECOND)
+          segment_seamless = playback_rate >= 0;
+      }
+    play_next();
+  }
+
+  /* the virtual tracks of a file are its chapters */
+  void
+  set_cue_chapters (const string& file_uri)
+  {
+    chapters.clear();
+    for (vector<string>::const_iterator ui = uris.begin(); ui != uris.end(); ui++)
+      {
+        string uri;
+        gint64 start, end;
+        if (split_time_fragment (*ui, uri, start, end) && uri == file_uri)
+          {
+            Chapter chapter;
+            chapter.start_time = start;
+
+            const PlaylistEntry *info = find_playlist_info (*ui);
+            if (info)
+              chapter.title = info->title;
+            chapters.push_back (chapter);
+          }
+      }
+    cue_chapters = true;
   }
 
   void
@@ -586,11 +1487,23 @@ struct Player : public KeyHandler
   void
   quit()
   {
+    if (finish_render_track (FINISH_QUIT))
+      return;   // continued once the rendered track is finished
+
     // End with a newline to preserve the time so the user knows where they
     // left off.
+    status_line.keep();
     Msg::print ("\n\n");
 
     gst_element_set_state (playbin, GST_STATE_NULL);
+    StartupTrace::the().finish();  // if we never reached playing state
+    print_qos_summary();
+    if (render.enabled())
+      render.print_summary();
+    if (options.profile)
+      profiler.print_summary();
+    if (options.track_switch_stats)
+      Msg::print ("%s", track_switch.format().c_str());
     if (loop)
       g_main_loop_quit (loop);
   }
@@ -624,56 +1537,64 @@ struct Player : public KeyHandler
     if (n >= chapters.size())
       return;
     chapter = chapters[n];
+
+    if (cue_chapters)
+      {
+        /* play the virtual track, so that the segment, title, ... are right */
+        for (guint pos = 0; pos < uris.size(); pos++)
+          {
+            string uri;
+            gint64 start, end;
+            if (split_time_fragment (uris[pos], uri, start, end) && uri == segment_uri && start == chapter.start_time)
+              {
+                play_position = pos;
+                play_next();
+                return;
+              }
+          }
+      }
     seek (chapter.start_time);
   }
 
   void process_input (int key);
   void print_keyboard_help();
-  void add_uri_or_directory (const string& name);
-
-  Player() : playbin (0), loop(0), play_position (0)
+  void add_uri_or_directory (const string& name, const PlaylistEntry *info = NULL);
+  void playlist_entry (const PlaylistEntry& entry, bool is_directory);
+  void playlist_error (const string& playlist, const string& error);
+  void playlist_warning (const string& playlist, const string& warning);
+  void playlist_done();
+  void metadata_discovered (const string& uri, const Metadata& metadata);
+
+  Player() : total_duration (0), total_unknown (0), played_duration (0), played_unknown (0), played_pos (0),
+             playbin (0), loop(0), play_position (0), last_state (GST_STATE_NULL),
+             status_timeout_id (0), status_interval (0), tags_timeout_id (0), status_position_id (0),
+             muted (false),
+             seek_start_time (0),
+             segment_start (0), segment_end (-1), segment_seamless (false), cue_chapters (false),
+             lazy (false), playlist_loading (false), playlist_waiting (false), exit_status (0)
   {
+    stdout_is_tty = isatty (STDOUT_FILENO);
+    track_finished = true;
+    render_finishing = FINISH_NONE;
+    render_finish_timeout_id = 0;
+    gapless_position = 0;
+    gapless_started = false;
+    g_mutex_init (&gapless_mutex);
+
     playback_rate = 1.0;
     playback_rate_step = pow (2, 1.0 / 7); // approximately 10%, but 7 steps will make playback rate double
     cols = get_columns();
+    status_line.set_width (cols);
   }
-};
-
-static void
-collect_tags (const GstTagList *tag_list,
-              const gchar *tag,
-	      gpointer user_data)
-{
-  Tags& tags = *(Tags *) user_data;
-  char *value;
-  if (strcmp (tag, GST_TAG_TITLE) == 0 && gst_tag_list_get_string (tag_list, GST_TAG_TITLE, &value))
-    tags.title = value;
-  if (strcmp (tag, GST_TAG_ARTIST) == 0 && gst_tag_list_get_string (tag_list, GST_TAG_ARTIST, &value))
-    tags.artist = value;
-  if (strcmp (tag, GST_TAG_ALBUM) == 0 && gst_tag_list_get_string (tag_list, GST_TAG_ALBUM, &value))
-    tags.album = value;
-  if (strcmp (tag, GST_TAG_GENRE) == 0 && gst_tag_list_get_string (tag_list, GST_TAG_GENRE, &value))
-    tags.genre = value;
-  if (strcmp (tag, GST_TAG_COMMENT) == 0 && gst_tag_list_get_string (tag_list, GST_TAG_COMMENT, &value))
-    tags.comment = value;
-  if (strcmp (tag, GST_TAG_AUDIO_CODEC) == 0 && gst_tag_list_get_string (tag_list, GST_TAG_AUDIO_CODEC, &value))
-    tags.codec = value;
-  if (strcmp (tag, GST_TAG_BITRATE) == 0)
-    gst_tag_list_get_uint (tag_list, GST_TAG_BITRATE, &tags.bitrate);
-  if (strcmp (tag, GST_TAG_VIDEO_CODEC) == 0 && gst_tag_list_get_string (tag_list, GST_TAG_VIDEO_CODEC, &value))
-    tags.vcodec = value;
-
-  if (strcmp (tag, GST_TAG_DATE) == 0)
-    {
-      GDate *date = NULL;
-      gst_tag_list_get_date (tag_list, GST_TAG_DATE, &date);
 
-      char outstr[200];
-      if (g_date_strftime (outstr, sizeof (outstr), "%Y", date))
-	tags.date = outstr;
-      g_date_free (date);
-    }
-}
+  void
+  update_columns()
+  {
+    cols = get_columns();
+    status_line.set_width (cols);
+    update_status_line();
+  }
+};
 
 class IdleResizeWindow
 {
@@ -718,6 +1639,22 @@ caps_set_cb (GObject *pad, GParamSpec *pspec, Player* player)
     }
 }
 
+static void
+about_to_finish_cb (GstElement *playbin, gpointer data)
+{
+  // this callback doesn't occur in main thread
+  Player& player = *(Player *) data;
+
+  g_mutex_lock (&player.gapless_mutex);
+  if (player.gapless_uri != "")
+    {
+      g_object_set (G_OBJECT (playbin), "uri", player.gapless_uri.c_str(), NULL);
+      player.gapless_uri = "";
+      player.gapless_started = true;
+    }
+  g_mutex_unlock (&player.gapless_mutex);
+}
+
 static void
 collect_element (const GValue *evalue, gpointer list_ptr)
 {
@@ -751,15 +1688,56 @@ collect_print_elements (GstElement *parent, const list<GstElement*>& elements)
     return element_name;
 }
 
+/* sets the window of a video sink which asked for it before the display was initialized */
+static gboolean
+cb_init_display (gpointer data)
+{
+  GstElement *overlay = static_cast<GstElement *> (data);
+
+  if (gtk_interface.init_display())
+    gst_video_overlay_set_window_handle (GST_VIDEO_OVERLAY (overlay), gtk_interface.window_xid_nolock());
+
+  gst_object_unref (overlay);
+  return FALSE;
+}
+
 static GstBusSyncReply
 my_sync_bus_callback (GstBus * bus, GstMessage * message, gpointer data)
 {
+  // this callback doesn't occur in main thread
+  Player& player = *(Player *) data;
+
   switch (GST_MESSAGE_TYPE (message)) {
+    case GST_MESSAGE_STREAM_START:
+      track_switch.mark (TrackSwitchStats::STREAM_START);
+      break;
+    case GST_MESSAGE_ASYNC_DONE:
+      track_switch.mark (TrackSwitchStats::PREROLL);
+      break;
+    case GST_MESSAGE_STATE_CHANGED:
+      if (GST_MESSAGE_SRC (message) == GST_OBJECT (player.playbin))
+        {
+          GstState new_state;
+          gst_message_parse_state_changed (message, NULL, &new_state, NULL);
+          if (new_state == GST_STATE_PLAYING)
+            track_switch.mark (TrackSwitchStats::PLAYING);
+        }
+      break;
     case GST_MESSAGE_ELEMENT:
       {
-        if (gst_is_video_overlay_prepare_window_handle_message (message) && gtk_interface.init_ok())
+        if (gst_is_video_overlay_prepare_window_handle_message (message))
           {
-            gst_video_overlay_set_window_handle (GST_VIDEO_OVERLAY (GST_MESSAGE_SRC (message)), gtk_interface.window_xid_nolock());
+            if (gtk_interface.display_ready())
+              {
+                gst_video_overlay_set_window_handle (GST_VIDEO_OVERLAY (GST_MESSAGE_SRC (message)), gtk_interface.window_xid_nolock());
+              }
+            else
+              {
+                /* we must not block the streaming thread until the main thread
+                 * initialized the display, so the window is set afterwards
+                 */
+                g_idle_add (cb_init_display, gst_object_ref (GST_MESSAGE_SRC (message)));
+              }
           }
       }
       break;
@@ -774,6 +1752,10 @@ my_sync_bus_callback (GstBus * bus, GstMessage * message, gpointer data)
 void
 Player::update_chapters (GstToc *toc)
 {
+  /* for virtual tracks, the cue sheet is used instead of the toc of the file */
+  if (cue_chapters)
+    return;
+
   chapters.clear();
 
   GList *entries = gst_toc_get_entries (toc);
@@ -823,16 +1805,44 @@ my_bus_callback (GstBus * bus, GstMessage * message, gpointer data)
       gst_message_parse_error (message, &err, &debug);
       player.overwrite_time_display();
       g_print ("Error: %s\n", err ? err->message : "<NULL Error>");
+      status_stream.send ("error", "\"message\":" + json_string (err ? err->message : "<NULL Error>"));
+      Metrics::the().decode_errors.inc();
       g_error_free (err);
       g_free (debug);
 
+      if (player.render_finishing != Player::FINISH_NONE)
+        {
+          /* the track was interrupted anyway */
+          player.render_track_finished();
+          break;
+        }
+      player.track_finished = true;
+      if (player.render_gapless())
+        {
+          g_print ("=> rendering to %s aborted\n\n", options.render);
+          player.quit();
+          break;
+        }
+      if (player.retry_without_video())
+        break;
       g_print ("=> file cannot be played and will be removed from playlist\n\n");
       player.remove_current_uri();
       player.play_next();
       break;
     }
+    case GST_MESSAGE_SEGMENT_DONE:
+      /* end of virtual track */
+      player.segment_done();
+      break;
     case GST_MESSAGE_EOS:
       /* end-of-stream */
+      status_stream.send ("eos");
+      if (player.render_finishing != Player::FINISH_NONE)
+        {
+          player.render_track_finished();
+          break;
+        }
+      player.track_finished = true;
       player.play_next();
       break;
     case GST_MESSAGE_TAG:
@@ -842,6 +1852,7 @@ my_bus_callback (GstBus * bus, GstMessage * message, gpointer data)
 	gst_tag_list_foreach (tag_list, collect_tags, &player.tags);
 	gst_tag_list_free (tag_list);
 	player.tags.timestamp = get_time();
+	player.schedule_tags_display();
       }
       break;
     case GST_MESSAGE_STATE_CHANGED:
@@ -862,9 +1873,57 @@ my_bus_callback (GstBus * bus, GstMessage * message, gpointer data)
             for (it = elements.begin(); it != elements.end(); it++)
               gst_object_unref (*it);
 	  }
-	player.last_state = state;
+	if (state != player.last_state)
+	  {
+	    char *state_name = g_ascii_strdown (gst_element_state_get_name (state), -1);
+	    status_stream.send ("state", "\"state\":" + json_string (state_name));
+	    g_free (state_name);
+
+	    if (state == GST_STATE_PLAYING)
+	      StartupTrace::the().finish();
+	    if (state == GST_STATE_PLAYING && track_switch.complete())
+	      track_switch.finish();
+	    player.last_state = state;
+	    player.schedule_status_update();
+	    player.schedule_position_events();
+	    player.update_status_line();
+	  }
+      }
+      break;
+    case GST_MESSAGE_BUFFERING:
+      {
+        static gint last_percent = -1;
+        gint percent;
+
+        gst_message_parse_buffering (message, &percent);
+        if (percent != last_percent)
+          {
+            if (percent < 100 && last_percent == 100 && player.last_state == GST_STATE_PLAYING)
+              Metrics::the().underruns.inc();
+
+            status_stream.send ("buffering", string_printf ("\"percent\":%d", percent));
+            last_percent = percent;
+          }
+      }
+      break;
+    case GST_MESSAGE_QOS:
+      {
+        guint64 old_dropped = player.qos.total_dropped();
+        if (player.qos.update (message))
+          {
+            if (player.qos.total_dropped() > old_dropped)
+              Metrics::the().dropped_frames.inc (player.qos.total_dropped() - old_dropped);
+            player.check_qos_warning();
+          }
       }
       break;
+    case GST_MESSAGE_ASYNC_DONE:
+      if (player.seek_start_time > 0)
+        {
+          Metrics::the().seek_seconds.observe (get_time() - player.seek_start_time);
+          player.seek_start_time = 0;
+        }
+      break;
     case GST_MESSAGE_TOC:
       {
         GstToc *toc;
@@ -872,7 +1931,10 @@ my_bus_callback (GstBus * bus, GstMessage * message, gpointer data)
         if (toc)
           {
             if (gst_toc_get_scope (toc) == GST_TOC_SCOPE_GLOBAL)
-              player.update_chapters (toc);
+              {
+                player.update_chapters (toc);
+                player.schedule_tags_display();
+              }
 
             gst_toc_unref (toc);
           }
@@ -885,6 +1947,9 @@ my_bus_callback (GstBus * bus, GstMessage * message, gpointer data)
 
   if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_STREAM_START)
     {
+      if (player.render_gapless())
+        player.gapless_stream_start();
+
       // try to figure out the video size
       GstElement *videosink = NULL;
       g_object_get (G_OBJECT (player.playbin), "video-sink", &videosink, NULL);
@@ -937,12 +2002,15 @@ my_bus_callback (GstBus * bus, GstMessage * message, gpointer data)
       g_object_get (player.playbin, "flags", &flags, NULL);
       g_object_get (player.playbin, "vis-plugin", &vis_plugin, NULL);
 
-      if (gtk_interface.init_ok())
+      if ((flags & GST_PLAY_FLAG_VIDEO) && (n_video || vis_plugin))
         {
-          if ((flags & GST_PLAY_FLAG_VIDEO) && (n_video || vis_plugin))
+          /* GTK/X11 is only initialized for the first track that needs a window */
+          if (gtk_interface.init_display())
             gtk_interface.show();
-          else
-            gtk_interface.hide();
+        }
+      else
+        {
+          gtk_interface.hide();
         }
     }
 
@@ -965,7 +2033,7 @@ sigint_usr_code (gint8    usignal,
   Player& player = *(Player *)data;
   double now = get_time();
   double elapsed_ms = (now - last_int) * 1000;
-  if (elapsed_ms > 0 && elapsed_ms < 500)
+  if ((elapsed_ms > 0 && elapsed_ms < 500) || player.render_gapless())
     player.quit();
   else
     player.play_next();
@@ -974,107 +2042,153 @@ sigint_usr_code (gint8    usignal,
   return TRUE;
 }
 
+static void
+sigwinch_handler (int signum)
+{
+  g_usignal_notify (signum);
+}
+
+static gboolean
+sigwinch_usr_code (gint8    usignal,
+                   gpointer data)
+{
+  Player& player = *(Player *)data;
+
+  /* terminal was resized */
+  player.update_columns();
+
+  return TRUE;
+}
+
 static gboolean
 cb_print_position (gpointer *data)
 {
   Player& player = *(Player *)data;
-  gint64 pos, len;
 
-  player.display_tags_and_chapters();
+  player.update_status_line();
 
-  if (gst_element_query_position (player.playbin, GST_FORMAT_TIME, &pos) &&
-      gst_element_query_duration (player.playbin, GST_FORMAT_TIME, &len))
+  if (player.status_interval != player.wanted_status_interval())
     {
-      guint pos_ms = (pos % GST_SECOND) / 1000000;
-      guint len_ms = (len % GST_SECOND) / 1000000;
-      guint pos_sec = pos / GST_SECOND;
-      guint len_sec = len / GST_SECOND;
-      guint pos_min = pos_sec / 60;
-      guint len_min = len_sec / 60;
+      /* switch between fast (playing) and slow (paused) tick */
+      player.status_timeout_id = 0;
+      player.schedule_status_update();
+      return FALSE;
+    }
 
-      player.overwrite_time_display();
-      Msg::print ("\rTime: %01u:%02u:%02u.%02u", pos_min / 60, pos_min % 60, pos_sec % 60, pos_ms / 10);
-      if (len > 0)   /* streams (i.e. http) have len == -1 */
-        Msg::print (" of %01u:%02u:%02u.%02u", len_min / 60, len_min % 60, len_sec % 60, len_ms / 10);
+  /* call me again */
+  return TRUE;
+}
 
-      string message = Msg::status();
-      if (message != "")
-        {
-          Msg::print (" | %s", message.c_str());
-        }
-      else
-        {
-          /* only print bitrate if no status message needs to be shown, in
-           * order to avoid too long output lines
-           */
-          if (player.tags.bitrate > 0)
-            Msg::print (" | Bitrate: %.1f kbit/sec", player.tags.bitrate / 1000.);
-        }
+static GstPadProbeReturn
+source_bytes_probe (GstPad *pad, GstPadProbeInfo *info, gpointer data)
+{
+  // this callback doesn't occur in main thread
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER_LIST)
+    {
+      /* some sources (udpsrc, for instance) push buffer lists */
+      GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+      if (list)
+        Metrics::the().bytes_read.inc (gst_buffer_list_calculate_size (list));
+    }
+  else
+    {
+      GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+      if (buffer)
+        Metrics::the().bytes_read.inc (gst_buffer_get_size (buffer));
+    }
 
-      string status, blanks;
-      // Print [MUTED] if sound is muted:
-      gboolean mute;
-      g_object_get (G_OBJECT (player.playbin), "mute", &mute, NULL);
+  return GST_PAD_PROBE_OK;
+}
 
-      if (mute)
-        status += " [MUTED]";
-      else
-        blanks += "        ";
+static void
+source_setup_cb (GstElement *playbin, GstElement *source, gpointer data)
+{
+  GstPad *pad = gst_element_get_static_pad (source, "src");
+  if (pad)
+    {
+      gst_pad_add_probe (pad, GstPadProbeType (GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST),
+                         source_bytes_probe, NULL, NULL);
+      gst_object_unref (pad);
+    }
+}
 
-      // Print [PAUSED] if paused:
-      bool pause = (player.last_state == GST_STATE_PAUSED);
+static gboolean
+cb_status_position (gpointer *data)
+{
+  Player& player = *(Player *)data;
 
-      if (pause)
-        status += " [PAUSED]";
-      else
-        blanks += "         ";
-      Msg::print ("%s%s\r", status.c_str(), blanks.c_str());
-      Msg::flush();
-    }
+  player.send_position_event();
 
   /* call me again */
   return TRUE;
 }
 
 static gboolean
-idle_start_player (gpointer *data)
+cb_display_tags (gpointer *data)
 {
   Player& player = *(Player *)data;
 
-  player.play_next();
+  player.tags_timeout_id = 0;
+
+  /* more tags arrived in the meantime: wait a bit longer */
+  double wait_ms = (player.tags.timestamp + 0.5 - get_time()) * 1000;
+  if (wait_ms > 0)
+    {
+      player.tags_timeout_id = g_timeout_add (wait_ms + 50, (GSourceFunc) cb_display_tags, &player);
+      return FALSE;
+    }
+  player.display_tags_and_chapters();
 
   /* do not call me again */
   return FALSE;
 }
 
+static void
+notify_mute_cb (GObject *object, GParamSpec *pspec, gpointer data)
+{
+  // this callback doesn't necessarily occur in main thread
+  Player& player = *(Player *)data;
+  gboolean mute;
 
-enum FileInfo { FI_DIR, FI_REG, FI_OTHER, FI_ERROR };
+  g_object_get (object, "mute", &mute, NULL);
+  player.muted = mute;
+}
 
-static inline FileInfo
-file_info (const string& path)
+static gboolean
+cb_print_profile (gpointer *data)
 {
-  struct stat st;
+  Player& player = *(Player *)data;
 
-  if (lstat (path.c_str(), &st) == 0)
+  string top = profiler.format_top (5);
+  if (top != "")
     {
-      if (S_ISDIR (st.st_mode))
-        return FI_DIR;
-      else if (S_ISREG (st.st_mode))
-        return FI_REG;
-      else
-        {
-          if (stat (path.c_str(), &st) == 0 && S_ISREG (st.st_mode))
-            return FI_REG;
-          else
-            return FI_OTHER;
-        }
+      player.overwrite_time_display();
+      Msg::print ("%s\n", top.c_str());
     }
-  return FI_ERROR;
+
+  /* call me again */
+  return TRUE;
+}
+
+static gboolean
+idle_start_player (gpointer *data)
+{
+  Player& player = *(Player *)data;
+
+  player.play_next();
+
+  /* do not call me again */
+  return FALSE;
 }
 
+
 static vector<string>
 crawl (const string& path)
 {
+  /* library directories are looked up in the index, which only rereads changed directories */
+  if (Library::the().contains (path))
+    return Library::the().files (path);
+
   vector<string> results;
 
   GDir *dir = g_dir_open (path.c_str(), 0, NULL);
@@ -1084,8 +2198,8 @@ crawl (const string& path)
 
       while ((name = g_dir_read_name (dir)))
         {
-          char *full_name = g_build_filename (path.c_str(), name, NULL);
-          FileInfo finfo = file_info (full_name);
+          string full_name = UriResolver::join_path (path, name);
+          FileInfo finfo = UriResolver::file_info (full_name);
 
           if (finfo == FI_DIR)
             {
@@ -1096,7 +2210,6 @@ crawl (const string& path)
             {
               results.push_back (full_name);
             }
-          g_free (full_name);
         }
       g_dir_close (dir);
     }
@@ -1109,6 +2222,19 @@ crawl (const string& path)
 void
 Player::process_input (int key)
 {
+  if (render.enabled())
+    {
+      /* seeking (flushing) would truncate the output file, and volume changes
+       * would affect the rendered audio, so only a few keys are allowed here
+       */
+      bool allowed = (key == 'q' || key == 'Q' || key == ' ' || key == '?' || key == 't' ||
+                      (render.per_track() && (key == 'n' || key == 'N')));
+      if (!allowed)
+        {
+          Msg::update_status ("Key not available while rendering");
+          return;
+        }
+    }
   switch (key)
     {
       case KEY_HANDLER_RIGHT:
@@ -1198,10 +2324,17 @@ Player::process_input (int key)
             seek_chapter (cur_chapter - 1);
         }
         break;
+      case 't':
+        overwrite_time_display();
+        Msg::print ("\n%s\n", track_switch.format().c_str());
+        break;
       case '?':
         print_keyboard_help();
         break;
     }
+  /* show the effect of the key now, the status timer may be slow (paused) */
+  if (key != 'q' && key != 'Q')
+    update_status_line();
 }
 
 void
@@ -1227,6 +2360,7 @@ Player::print_keyboard_help()
   printf ("   < >                  -     jump to next/previous chapter\n");
   printf ("   Backspace            -     playback rate 1x\n");
   printf ("   n                    -     play next file\n");
+  printf ("   t                    -     show track switch times\n");
   printf ("   q                    -     quit gst123\n");
   printf ("   ?                    -     this help\n");
   printf ("=====================================================================\n");
@@ -1234,9 +2368,9 @@ Player::print_keyboard_help()
 }
 
 void
-Player::add_uri_or_directory (const string& name)
+Player::add_uri_or_directory (const string& name, const PlaylistEntry *info)
 {
-  if (file_info (name) == FI_DIR)          // => play all files in this dir
+  if (!lazy && UriResolver::file_info (name) == FI_DIR)  // => play all files in this dir
     {
       vector<string> uris = crawl (name);
       for (vector<string>::const_iterator ui = uris.begin(); ui != uris.end(); ui++)
@@ -1244,16 +2378,88 @@ Player::add_uri_or_directory (const string& name)
     }
   else
     {
-      add_uri (name);
+      add_uri (name, info);
+    }
+}
+
+/* called by the playlist loader (in the main thread) */
+void
+Player::playlist_entry (const PlaylistEntry& entry, bool is_directory)
+{
+  /* the loader already resolved the location, so we don't need to stat it again */
+  if (is_directory)
+    add_uri_or_directory (entry.location);
+  else
+    add_uri (entry.location, &entry);
+
+  if (playlist_waiting && !options.shuffle && play_position < uris.size())
+    {
+      playlist_waiting = false;
+      play_next();
+    }
+}
+
+void
+Player::playlist_error (const string& playlist, const string& error)
+{
+  /* entries we got so far (and other playlists) can still be played */
+  overwrite_time_display();
+  std::cerr << "Playlist Error: " << error << std::endl;
+  std::cerr << "Could not load playlist " << playlist << std::endl;
+  exit_status = -1;
+}
+
+void
+Player::playlist_warning (const string& playlist, const string& warning)
+{
+  overwrite_time_display();
+  std::cerr << "Playlist Warning: " << warning << std::endl;
+}
+
+void
+Player::playlist_done()
+{
+  playlist_loading = false;
+
+  if (playlist_waiting)
+    {
+      playlist_waiting = false;
+      if (uris.empty())
+        exit_status = -1;
+      play_next();
     }
 }
 
+/* called by the discovery (in the main thread) */
+void
+Player::metadata_discovered (const string& uri, const Metadata& metadata)
+{
+  if (metadata.duration <= 0 && metadata.title == "")
+    return;
+
+  double old_duration = entry_duration (uri);
+  PlaylistEntry& info = playlist_info[uri];
+
+  /* the real duration is more accurate than the one from the playlist file,
+   * but the title from the playlist is what the user chose to see
+   */
+  info.location = uri;
+  if (metadata.duration > 0)
+    info.duration = metadata.duration;
+  if (info.title == "" && metadata.title != "")
+    info.title = metadata.artist != "" ? metadata.artist + " - " + metadata.title : metadata.title;
+
+  duration_changed (uri, old_duration);
+}
+
 gint
 main (gint   argc,
       gchar *argv[])
 {
+  StartupTrace::the().phase ("player setup");
   Player player;
 
+  StartupTrace::the().phase ("XInitThreads");
   if (XInitThreads() == 0)
     {
       fprintf (stderr, "%s: Failed to initialize Xlib support for concurrent threads (XInitThreads() failed).\n", argv[0]);
@@ -1261,9 +2467,11 @@ main (gint   argc,
     }
 
   /* Setup options */
+  StartupTrace::the().phase ("option parsing, config file");
   options.parse (argc, argv);
 
   /* init GStreamer */
+  StartupTrace::the().phase ("gst_init");
   gst_init (&argc, &argv);
   gtk_interface.init (&argc, &argv, &player);
 
@@ -1276,46 +2484,79 @@ main (gint   argc,
   player.loop = g_main_loop_new (NULL, FALSE);
 
   /* set up */
+  StartupTrace::the().phase ("directory crawling");
+
+  /* the batch modes need the complete list of files, and don't show durations or tags */
+  player.lazy = options.lazy && !options.benchmark && options.jobs <= 0;
+  if (options.discover > 0 && !options.benchmark && options.jobs <= 0)
+    player.discovery.start (options.discover, &player);
   if (options.uris)
     {
       for (int i = 0; options.uris[i]; i++)
         player.add_uri_or_directory (options.uris[i]);
     }
+  Library::the().save();
+
+  StartupTrace::the().phase ("playlist parsing");
 
-  for (list<string>::iterator pi = options.playlists.begin(); pi != options.playlists.end(); pi++)
+  /* playlists are parsed in the background while playing, unless we need the
+   * complete list before we start (batch modes, rendering) or stdin is used
+   */
+  bool stream_playlists = !options.benchmark && options.jobs <= 0 && !options.render &&
+                          std::find (options.playlists.begin(), options.playlists.end(), "-") == options.playlists.end();
+  PlaylistLoader playlist_loader;
+  if (!options.playlists.empty())
     {
-      Playlist pls (*pi);
+      player.playlist_loading = true;
+      playlist_loader.start (options.playlists, &player, !player.lazy);
 
-      if (!pls.is_valid())
+      if (!stream_playlists)
         {
-          std::cerr << "Could not load playlist " << *pi << std::endl;
-          return -1;
-        }
+          while (player.playlist_loading)
+            g_main_context_iteration (NULL, TRUE);
 
-      char *playlist_dirname = g_path_get_dirname (pi->c_str());
-      for (unsigned int i = 0; i < pls.size(); i++)
-        {
-          if ((pls[i].find (":") == string::npos) && !g_path_is_absolute (pls[i].c_str()))
-            {
-              char *filename = g_build_filename (playlist_dirname, pls[i].c_str(), NULL);
-              player.add_uri_or_directory (filename);
-              g_free (filename);
-            }
-          else
-            player.add_uri_or_directory (pls[i].c_str());
+          if (player.exit_status != 0)
+            return -1;
         }
-      g_free (playlist_dirname);
     }
   /* make sure we have a URI */
-  if (player.uris.empty())
+  if (player.uris.empty() && !player.playlist_loading)
     {
       /* Don't print usage if a playlist was provided */
       if (!options.playlists.size())
         printf ("%s", options.usage.c_str());
       return -1;
     }
+  if (options.benchmark)
+    {
+      string error;
+      Batch batch (player.media_uris());
+      if (!batch.init_benchmark (!options.novideo, error))
+        {
+          printf ("%s: %s\n", argv[0], error.c_str());
+          return -1;
+        }
+      return batch.run();
+    }
+  if (options.jobs > 0)
+    {
+      if (!options.render)
+        {
+          printf ("%s: batch mode (--jobs) needs an output filename (--render)\n", argv[0]);
+          return -1;
+        }
+      string error;
+      Batch batch (player.media_uris());
+      if (!batch.init_render (options.jobs, options.render, error))
+        {
+          printf ("%s: %s\n", argv[0], error.c_str());
+          return -1;
+        }
+      return batch.run();
+    }
+  StartupTrace::the().phase ("pipeline setup");
   player.playbin = gst_element_factory_make ("playbin", "play");
-  if (options.novideo || !gtk_interface.init_ok())
+  if (options.novideo || !GtkInterface::have_display())
     {
       GstElement *fakesink = gst_element_factory_make ("fakesink", "novid");
       g_object_set (G_OBJECT (player.playbin), "video-sink", fakesink, NULL);
@@ -1363,6 +2604,54 @@ main (gint   argc,
           g_object_set (G_OBJECT (player.playbin), "audio-sink", audio_sink, NULL);
         }
     }
+  if (options.render)
+    {
+      string error;
+      if (!render.init (options.render, error))
+        {
+          printf ("%s: %s\n", argv[0], error.c_str());
+          return -1;
+        }
+      g_object_set (G_OBJECT (player.playbin), "audio-sink", render.sink(), NULL);
+
+      /* only audio is rendered */
+      GstElement *fakesink = gst_element_factory_make ("fakesink", "novid");
+      g_object_set (G_OBJECT (player.playbin), "video-sink", fakesink, NULL);
+
+      int flags;
+      g_object_get (player.playbin, "flags", &flags, NULL);
+      g_object_set (player.playbin, "flags", flags & ~GST_PLAY_FLAG_VIDEO, NULL);
+
+      if (!render.per_track())
+        {
+          if (!player.check_render_gapless (error))
+            {
+              printf ("%s: %s\n", argv[0], error.c_str());
+              return -1;
+            }
+          Msg::print ("Writing %s\n", options.render);
+          g_signal_connect (player.playbin, "about-to-finish", G_CALLBACK (about_to_finish_cb), &player);
+        }
+    }
+  if (options.metrics)
+    {
+      string error;
+      if (!Metrics::the().listen (options.metrics, error))
+        {
+          printf ("%s: %s\n", argv[0], error.c_str());
+          return -1;
+        }
+      g_signal_connect (player.playbin, "source-setup", G_CALLBACK (source_setup_cb), NULL);
+    }
+  if (options.status_fd >= 0)
+    {
+      string error;
+      if (!status_stream.init (options.status_fd, error))
+        {
+          printf ("%s: %s\n", argv[0], error.c_str());
+          return -1;
+        }
+    }
   if (options.initial_volume >= 0)
     {
       g_object_set (G_OBJECT (player.playbin), "volume", options.initial_volume / 100, NULL);
@@ -1378,20 +2667,32 @@ main (gint   argc,
   gst_bus_add_watch (bus, my_bus_callback, &player);
   gst_object_unref (bus);
 
-  g_timeout_add (130, (GSourceFunc) cb_print_position, &player);
+  g_signal_connect (player.playbin, "notify::mute", G_CALLBACK (notify_mute_cb), &player);
+  player.schedule_status_update();
+  if (options.profile)
+    {
+      profiler.attach (player.playbin);
+      g_timeout_add_seconds (5, (GSourceFunc) cb_print_profile, &player);
+    }
   g_idle_add ((GSourceFunc) idle_start_player, &player);
   signal (SIGINT, sigint_handler);
   g_usignal_add (SIGINT, sigint_usr_code, &player);
+  signal (SIGWINCH, sigwinch_handler);
+  g_usignal_add (SIGWINCH, sigwinch_usr_code, &player);
 
   /* now run */
+  StartupTrace::the().phase ("first track: open, preroll, start playing");
   terminal.init (player.loop, &player);
   g_main_loop_run (player.loop);
   terminal.end();
   gtk_interface.end();
+  playlist_loader.cancel();
+  player.discovery.cancel();
+  Library::the().save();     // directories may have been added with --lazy
 
   /* also clean up */
   gst_element_set_state (player.playbin, GST_STATE_NULL);
   gst_object_unref (GST_OBJECT (player.playbin));
 
-  return 0;
+  return player.exit_status;
 }
@@ -21,6 +21,8 @@
 #include "gtkinterface.h"
 #include "options.h"
 #include "msg.h"
+#include "configfile.h"
+#include "utils.h"
 
 #include <gtk/gtk.h>
 #include <X11/Xlib.h>
@@ -28,6 +30,8 @@
 #include <gdk/gdkx.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/wait.h>
+#include <errno.h>
 
 using std::string;
 using namespace Gst123;
@@ -86,22 +90,69 @@ window_state_event_cb (GtkWidget *widget,
 }
 
 GtkInterface::GtkInterface() :
+  gtk_window (NULL),
+  gtk_window_visible (false),
   window_xid (0),
+  cursor_timeout_id (0),
+  cursor_motion_time (0),
+  cursor_hidden (false),
   video_width (0),
   video_height (0),
   video_fullscreen (false),
   video_maximized (false),
-  need_resize_window (false)
+  need_resize_window (false),
+  init_argc (NULL),
+  init_argv (NULL),
+  display_init_done (false),
+  screen_saver_setting (RESUME),
+  screen_saver_spawned (RESUME),
+  screen_saver_pid (0),
+  screen_saver_wid (0)
 {
+  g_mutex_init (&display_init_mutex);
 }
 
+/* the cursor is hidden if the mouse wasn't moved for this time */
+static const double CURSOR_HIDE_SECONDS = 1.5;
+
 void
 GtkInterface::init (int *argc, char ***argv, KeyHandler *handler)
 {
   key_handler = handler;
+  init_argc = argc;
+  init_argv = argv;
+
+  /* initialize map from Gdk keysyms to KeyHandler codes */
+  key_map[GDK_KEY_Page_Up]     = KEY_HANDLER_PAGE_UP;
+  key_map[GDK_KEY_Page_Down]   = KEY_HANDLER_PAGE_DOWN;
+  key_map[GDK_KEY_Left]        = KEY_HANDLER_LEFT;
+  key_map[GDK_KEY_Right]       = KEY_HANDLER_RIGHT;
+  key_map[GDK_KEY_Up]          = KEY_HANDLER_UP;
+  key_map[GDK_KEY_Down]        = KEY_HANDLER_DOWN;
+  key_map[GDK_KEY_BackSpace]   = KEY_HANDLER_BACKSPACE;
+  key_map[GDK_KEY_KP_Add]      = '+';
+  key_map[GDK_KEY_KP_Subtract] = '-';
+}
+
+/* X11 is only used if a display is configured, and GTK is only initialized
+ * once the first video (or visualization) needs to be shown; whether the
+ * display can actually be used is only known after init_display()
+ */
+bool
+GtkInterface::have_display()
+{
+  return g_getenv ("DISPLAY") != NULL;
+}
+
+/* must be called from main thread, returns init_ok() */
+bool
+GtkInterface::init_display()
+{
+  if (display_init_done)
+    return init_ok();
 
   gdk_set_allowed_backends ("x11");
-  if (gtk_init_check (argc, argv))
+  if (gtk_init_check (init_argc, init_argv))
     {
       gtk_window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
       gtk_window_set_icon_name (GTK_WINDOW (gtk_window), "multimedia-player");
@@ -130,25 +181,27 @@ GtkInterface::init (int *argc, char ***argv, KeyHandler *handler)
       GdkDisplay *display = gdk_display_get_default();
       invisible_cursor = gdk_cursor_new_for_display (display, GDK_BLANK_CURSOR);
 
-      cursor_timeout = 3;
-      g_timeout_add (500, (GSourceFunc) timeout_cb, this);
-    }
-  else
-    {
-      gtk_window = NULL;
+      if (!title.empty())
+        gtk_window_set_title (GTK_WINDOW (gtk_window), title.c_str());
     }
   gtk_window_visible = false;
 
-  /* initialize map from Gdk keysyms to KeyHandler codes */
-  key_map[GDK_KEY_Page_Up]     = KEY_HANDLER_PAGE_UP;
-  key_map[GDK_KEY_Page_Down]   = KEY_HANDLER_PAGE_DOWN;
-  key_map[GDK_KEY_Left]        = KEY_HANDLER_LEFT;
-  key_map[GDK_KEY_Right]       = KEY_HANDLER_RIGHT;
-  key_map[GDK_KEY_Up]          = KEY_HANDLER_UP;
-  key_map[GDK_KEY_Down]        = KEY_HANDLER_DOWN;
-  key_map[GDK_KEY_BackSpace]   = KEY_HANDLER_BACKSPACE;
-  key_map[GDK_KEY_KP_Add]      = '+';
-  key_map[GDK_KEY_KP_Subtract] = '-';
+  g_mutex_lock (&display_init_mutex);
+  display_init_done = true;
+  g_mutex_unlock (&display_init_mutex);
+
+  return init_ok();
+}
+
+/* may be called from any thread, doesn't block: true if init_display() succeeded */
+bool
+GtkInterface::display_ready()
+{
+  g_mutex_lock (&display_init_mutex);
+  bool ready = display_init_done && gtk_window != NULL;
+  g_mutex_unlock (&display_init_mutex);
+
+  return ready;
 }
 
 bool
@@ -222,6 +275,9 @@ GtkInterface::show()
       screen_saver (SUSPEND);
 
       gtk_window_visible = true;
+
+      cursor_motion_time = get_time();
+      start_cursor_timeout (CURSOR_HIDE_SECONDS);
     }
 }
 
@@ -242,6 +298,9 @@ GtkInterface::hide()
 
       screen_saver (RESUME);
       gtk_window_visible = false;
+
+      /* no timer needed while the window is hidden */
+      stop_cursor_timeout();
     }
 }
 
@@ -250,7 +309,9 @@ GtkInterface::end()
 {
   if (gtk_window != NULL)
     {
-      screen_saver (RESUME);
+      /* the main loop is no longer running, so only a sync dbus call works here */
+      idle_inhibitor.uninhibit_sync (500);
+      screen_saver_resume_sync (500);
     }
 }
 
@@ -328,7 +389,7 @@ GtkInterface::handle_keypress_event (GdkEventKey *event)
 
   if (ch != 0)
     {
-      key_handler->process_input (ch);
+      key_handler->process_input (ConfigFile::the().map_key (ch));
       return true;
     }
   return false;
@@ -346,28 +407,52 @@ GtkInterface::handle_buttonpress_event (GdkEventButton *event)
 }
 
 void
-GtkInterface::set_title (const string& title)
+GtkInterface::set_title (const string& new_title)
 {
+  title = new_title;
+
   if (gtk_window != NULL)
     gtk_window_set_title (GTK_WINDOW (gtk_window), title.c_str());
 }
 
+void
+GtkInterface::start_cursor_timeout (double seconds)
+{
+  if (!cursor_timeout_id)
+    cursor_timeout_id = g_timeout_add (seconds * 1000, (GSourceFunc) timeout_cb, this);
+}
+
+void
+GtkInterface::stop_cursor_timeout()
+{
+  if (cursor_timeout_id)
+    {
+      g_source_remove (cursor_timeout_id);
+      cursor_timeout_id = 0;
+    }
+}
+
 bool
 GtkInterface::handle_timeout()
 {
+  cursor_timeout_id = 0;
+
   if (gtk_window != NULL && gtk_window_visible)
     {
-      if (cursor_timeout == 0)
+      /* the timer is not restarted on every motion event, so check if the mouse was moved in the meantime */
+      double idle_time = get_time() - cursor_motion_time;
+
+      if (idle_time < CURSOR_HIDE_SECONDS)
         {
-          gdk_window_set_cursor (gtk_widget_get_window (gtk_window), invisible_cursor);
-          cursor_timeout = -1;
+          start_cursor_timeout (CURSOR_HIDE_SECONDS - idle_time);
         }
-      else if (cursor_timeout > 0)
+      else
         {
-          cursor_timeout--;
+          gdk_window_set_cursor (gtk_widget_get_window (gtk_window), invisible_cursor);
+          cursor_hidden = true;
         }
     }
-  return true;
+  return false; // one-shot
 }
 
 bool
@@ -375,8 +460,13 @@ GtkInterface::handle_motion_notify_event (GdkEventMotion *event)
 {
   if (gtk_window != NULL && gtk_window_visible)
     {
-      gdk_window_set_cursor (gtk_widget_get_window (gtk_window), visible_cursor);
-      cursor_timeout = 3;
+      if (cursor_hidden)
+        {
+          gdk_window_set_cursor (gtk_widget_get_window (gtk_window), visible_cursor);
+          cursor_hidden = false;
+        }
+      cursor_motion_time = get_time();
+      start_cursor_timeout (CURSOR_HIDE_SECONDS);
     }
   return true;
 }
@@ -422,19 +512,126 @@ GtkInterface::screen_saver (ScreenSaverSetting setting)
     {
       /* use different methods to disable screensaver (communicate directly via
        * dbus and use xdg-screensaver), hopefully at least one works
+       *
+       * both are asynchronous: a slow session bus or a slow xdg-screensaver
+       * script should not block the main loop while we start playing a video
        */
       if (setting == SUSPEND)
         idle_inhibitor.inhibit(); // fail silently if something goes wrong here
       if (setting == RESUME)
         idle_inhibitor.uninhibit();
 
-      guint64 wid = GDK_WINDOW_XID (window);
+      screen_saver_xdg (setting);
+    }
+}
 
-      const char *setting_str = (setting == SUSPEND) ? "suspend" : "resume";
+void
+GtkInterface::screen_saver_xdg (ScreenSaverSetting setting)
+{
+  GdkWindow *window = gtk_widget_get_window (gtk_window);
+  if (window)
+    {
+      screen_saver_wid = GDK_WINDOW_XID (window);
+      screen_saver_setting = setting;
+      screen_saver_spawn();
+    }
+}
 
-      char *cmd = g_strdup_printf ("xdg-screensaver %s %" G_GUINT64_FORMAT " >/dev/null 2>&1", setting_str, wid);
-      int rc = system (cmd);   // don't complain if xdg-screensaver is not installed
-      (void) rc;
-      g_free (cmd);
+/* run xdg-screensaver for screen_saver_setting, unless it is still running
+ * for the previous setting (in that case, child_watch_cb will call us again)
+ */
+void
+GtkInterface::screen_saver_spawn()
+{
+  if (screen_saver_pid != 0 || screen_saver_setting == screen_saver_spawned)
+    return;
+
+  GPid pid;
+  if (spawn_xdg_screensaver (screen_saver_setting, &pid))
+    {
+      screen_saver_pid = pid;
+      g_child_watch_add (pid, screen_saver_child_watch_cb, this);
     }
+  screen_saver_spawned = screen_saver_setting;
+}
+
+bool
+GtkInterface::spawn_xdg_screensaver (ScreenSaverSetting setting, GPid *pid)
+{
+  char *wid_str = g_strdup_printf ("%" G_GUINT64_FORMAT, screen_saver_wid);
+  char *argv[] = {
+    (char *) "xdg-screensaver",
+    (char *) (setting == SUSPEND ? "suspend" : "resume"),
+    wid_str,
+    NULL
+  };
+  GSpawnFlags flags = GSpawnFlags (G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD |
+                                   G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL);
+  // don't complain if xdg-screensaver is not installed
+  bool ok = g_spawn_async (NULL, argv, NULL, flags, NULL, NULL, pid, NULL);
+  g_free (wid_str);
+
+  return ok;
+}
+
+/* waits until the child exits, but not after end_time (monotonic time); a
+ * child which is already gone (reaped by glib's child watch) counts as exited
+ */
+static bool
+wait_child (GPid pid, gint64 end_time)
+{
+  pid_t result;
+
+  while ((result = waitpid (pid, NULL, WNOHANG)) == 0 || (result < 0 && errno == EINTR))
+    {
+      if (g_get_monotonic_time() >= end_time)
+        return false;
+      g_usleep (10 * 1000);
+    }
+  return true;
+}
+
+/* used on exit: the main loop is no longer running, so the child watch would
+ * neither reap a running xdg-screensaver nor start the next one
+ */
+void
+GtkInterface::screen_saver_resume_sync (int timeout_ms)
+{
+  GdkWindow *window = gtk_widget_get_window (gtk_window);
+  if (!window || (screen_saver_pid == 0 && screen_saver_spawned == RESUME))
+    return;
+
+  gint64 end_time = g_get_monotonic_time() + timeout_ms * 1000;
+
+  screen_saver_wid = GDK_WINDOW_XID (window);
+  screen_saver_setting = RESUME;
+
+  /* a suspend which is still running must finish before we resume */
+  if (screen_saver_pid != 0)
+    {
+      bool exited = wait_child (screen_saver_pid, end_time);
+      g_spawn_close_pid (screen_saver_pid);
+      screen_saver_pid = 0;
+      if (!exited || screen_saver_spawned == RESUME)
+        return;
+    }
+
+  GPid pid;
+  if (spawn_xdg_screensaver (RESUME, &pid))
+    {
+      /* if it takes too long, we leave it running: killing it could keep the screensaver suspended */
+      wait_child (pid, end_time);
+      g_spawn_close_pid (pid);
+    }
+  screen_saver_spawned = RESUME;
+}
+
+void
+GtkInterface::screen_saver_child_watch_cb (GPid pid, gint status, gpointer data)
+{
+  GtkInterface *self = static_cast<GtkInterface *> (data);
+
+  g_spawn_close_pid (pid);
+  self->screen_saver_pid = 0;
+  self->screen_saver_spawn();
 }
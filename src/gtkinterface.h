@@ -38,7 +38,9 @@ class GtkInterface
   KeyHandler  *key_handler;
   GdkCursor   *invisible_cursor;
   GdkCursor   *visible_cursor;
-  int          cursor_timeout;      // number of timeout events until we hide the cursor (-1 if already hidden)
+  guint        cursor_timeout_id;   // one-shot timer which hides the cursor (0 if not armed)
+  double       cursor_motion_time;  // last time the pointer was moved
+  bool         cursor_hidden;
 
   int          video_width;
   int          video_height;
@@ -48,19 +50,40 @@ class GtkInterface
   bool         need_resize_window;
 
   std::map<int,int>   key_map;
+  std::string         title;
+
+  int         *init_argc;
+  char      ***init_argv;
+  GMutex       display_init_mutex;
+  bool         display_init_done;        // protected by display_init_mutex
 
   IdleInhibitor idle_inhibitor;
 
   enum ScreenSaverSetting { SUSPEND, RESUME };
+  ScreenSaverSetting  screen_saver_setting;   // wanted xdg-screensaver state
+  ScreenSaverSetting  screen_saver_spawned;   // state last passed to xdg-screensaver
+  GPid                screen_saver_pid;       // running xdg-screensaver (0 if none)
+  guint64             screen_saver_wid;
+
   void screen_saver (ScreenSaverSetting setting);
+  void screen_saver_xdg (ScreenSaverSetting setting);
+  void screen_saver_spawn();
+  void screen_saver_resume_sync (int timeout_ms);
+  bool spawn_xdg_screensaver (ScreenSaverSetting setting, GPid *pid);
+  static void screen_saver_child_watch_cb (GPid pid, gint status, gpointer data);
   void send_net_active_window_event();
   bool is_fullscreen();
   bool is_maximized();
   void resize_window_if_needed();
+  void start_cursor_timeout (double seconds);
+  void stop_cursor_timeout();
 public:
   GtkInterface();
 
   void init (int *argc, char ***argv, class KeyHandler *key_handler);
+  bool init_display();
+  bool display_ready();
+  static bool have_display();
   void end();
   void show();
   void hide();
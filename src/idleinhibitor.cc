@@ -24,83 +24,188 @@ using namespace Gst123;
 
 IdleInhibitor::~IdleInhibitor()
 {
-  uninhibit();
-
+  if (cancellable_)
+    {
+      g_cancellable_cancel (cancellable_);
+      g_object_unref (cancellable_);
+    }
   if (proxy_)
     g_object_unref (proxy_);
 }
 
-bool
+void
 IdleInhibitor::inhibit()
 {
-  if (cookie_ != 0)
-    return true; // Already inhibited.
+  want_inhibit_ = true;
+  update();
+}
 
-  GError* error = nullptr;
+void
+IdleInhibitor::uninhibit()
+{
+  want_inhibit_ = false;
+  update();
+}
+
+bool
+IdleInhibitor::is_inhibited() const
+{
+  return cookie_ != 0;
+}
+
+/* start the next D-Bus call needed to reach the wanted state (if any) */
+void
+IdleInhibitor::update()
+{
+  if (proxy_failed_ || call_pending_)
+    return;
+
+  if (!cancellable_)
+    cancellable_ = g_cancellable_new();
 
   if (!proxy_)
     {
-      proxy_ = g_dbus_proxy_new_for_bus_sync (
-        G_BUS_TYPE_SESSION,
-        G_DBUS_PROXY_FLAGS_NONE,
-        nullptr,
-        "org.freedesktop.ScreenSaver",
-        "/org/freedesktop/ScreenSaver",
-        "org.freedesktop.ScreenSaver",
-        nullptr,
-        &error
-      );
-
-      if (!proxy_)
+      if (want_inhibit_ && !proxy_requested_)
         {
-          // fail silently
-          // g_warning ("Could not create ScreenSaver D-Bus proxy: %s", error ? error->message : "unknown error");
-          g_clear_error (&error);
-          return false;
+          proxy_requested_ = true;
+          g_dbus_proxy_new_for_bus (
+            G_BUS_TYPE_SESSION,
+            GDBusProxyFlags (G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES | G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS),
+            nullptr,
+            "org.freedesktop.ScreenSaver",
+            "/org/freedesktop/ScreenSaver",
+            "org.freedesktop.ScreenSaver",
+            cancellable_,
+            proxy_ready_cb,
+            this
+          );
         }
+      return;
     }
 
-  GVariant* result = g_dbus_proxy_call_sync (
-    proxy_,
-    "Inhibit",
-    g_variant_new ("(ss)", "gst123", "Playing a video"),
-    G_DBUS_CALL_FLAGS_NONE,
-    -1,
-    nullptr,
-    &error
-  );
+  if (want_inhibit_ && cookie_ == 0)
+    {
+      call_pending_ = true;
+      g_dbus_proxy_call (
+        proxy_,
+        "Inhibit",
+        g_variant_new ("(ss)", "gst123", "Playing a video"),
+        G_DBUS_CALL_FLAGS_NONE,
+        -1,
+        cancellable_,
+        inhibit_cb,
+        this
+      );
+    }
+  else if (!want_inhibit_ && cookie_ != 0)
+    {
+      call_pending_ = true;
+      g_dbus_proxy_call (
+        proxy_,
+        "UnInhibit",
+        g_variant_new ("(u)", cookie_),
+        G_DBUS_CALL_FLAGS_NONE,
+        -1,
+        cancellable_,
+        uninhibit_cb,
+        this
+      );
+      cookie_ = 0;
+    }
+}
 
-  if (!result)
+void
+IdleInhibitor::proxy_ready_cb (GObject* source, GAsyncResult* result, gpointer data)
+{
+  GError* error = nullptr;
+  GDBusProxy* proxy = g_dbus_proxy_new_for_bus_finish (result, &error);
+
+  if (!proxy)
     {
-      // fail silently
-      // g_warning ("Could not inhibit idle: %s", error ? error->message : "unknown error");
+      // fail silently (no session bus), but don't use our pointer after cancel
+      bool cancelled = g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+      g_clear_error (&error);
+      if (!cancelled)
+        static_cast<IdleInhibitor*> (data)->proxy_failed_ = true;
+      return;
+    }
+
+  IdleInhibitor* self = static_cast<IdleInhibitor*> (data);
+  self->proxy_ = proxy;
+  self->update();
+}
+
+void
+IdleInhibitor::inhibit_cb (GObject* source, GAsyncResult* result, gpointer data)
+{
+  GError* error = nullptr;
+  GVariant* reply = g_dbus_proxy_call_finish (G_DBUS_PROXY (source), result, &error);
+
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      g_clear_error (&error);
+      return;
+    }
+
+  IdleInhibitor* self = static_cast<IdleInhibitor*> (data);
+  self->call_pending_ = false;
+
+  if (!reply)
+    {
+      // fail silently, for instance if no screensaver service is running
       g_clear_error (&error);
-      return false;
+      self->proxy_failed_ = true;
+      return;
     }
 
   guint32 cookie = 0;
-  g_variant_get (result, "(u)", &cookie);
-  g_variant_unref (result);
+  g_variant_get (reply, "(u)", &cookie);
+  g_variant_unref (reply);
 
-  cookie_ = cookie;
+  self->cookie_ = cookie;
 
-  return true;
+  // uninhibit() may have been called while the call was in flight
+  self->update();
 }
 
 void
-IdleInhibitor::uninhibit()
+IdleInhibitor::uninhibit_cb (GObject* source, GAsyncResult* result, gpointer data)
 {
+  GError* error = nullptr;
+  GVariant* reply = g_dbus_proxy_call_finish (G_DBUS_PROXY (source), result, &error);
+
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      g_clear_error (&error);
+      return;
+    }
+  g_clear_error (&error);  // fail silently
+  if (reply)
+    g_variant_unref (reply);
+
+  IdleInhibitor* self = static_cast<IdleInhibitor*> (data);
+  self->call_pending_ = false;
+
+  // inhibit() may have been called while the call was in flight
+  self->update();
+}
+
+/* used on exit, when the main loop is no longer running to complete async calls */
+void
+IdleInhibitor::uninhibit_sync (int timeout_ms)
+{
+  want_inhibit_ = false;
+
   if (!proxy_ || cookie_ == 0)
     return;
 
   GError* error = nullptr;
-
   GVariant* result = g_dbus_proxy_call_sync (
     proxy_,
     "UnInhibit",
-    g_variant_new("(u)", cookie_),
+    g_variant_new ("(u)", cookie_),
     G_DBUS_CALL_FLAGS_NONE,
-    -1,
+    timeout_ms,
     nullptr,
     &error
   );
@@ -108,7 +213,6 @@ IdleInhibitor::uninhibit()
   if (!result)
     {
       // fail silently
-      // g_warning ("Could not remove idle inhibition: %s", error ? error->message : "unknown error");
       g_clear_error (&error);
     }
   else
@@ -117,9 +221,3 @@ IdleInhibitor::uninhibit()
     }
   cookie_ = 0;
 }
-
-bool
-IdleInhibitor::is_inhibited() const
-{
-  return cookie_ != 0;
-}
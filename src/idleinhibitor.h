@@ -25,6 +25,14 @@
 namespace Gst123
 {
 
+/*
+ * Inhibits the screensaver via org.freedesktop.ScreenSaver
+ *
+ * All D-Bus calls are asynchronous, so a missing or slow session bus can't
+ * stall playback. inhibit() and uninhibit() only record the wanted state;
+ * once the proxy is available and no call is in flight, the state is
+ * applied by the callbacks.
+ */
 class IdleInhibitor
 {
 public:
@@ -34,13 +42,25 @@ public:
   IdleInhibitor (const IdleInhibitor&) = delete;
   IdleInhibitor& operator= (const IdleInhibitor&) = delete;
 
-  bool inhibit();
+  void inhibit();
   void uninhibit();
+  void uninhibit_sync (int timeout_ms);
   bool is_inhibited() const;
 
 private:
+  void update();
+
+  static void proxy_ready_cb (GObject* source, GAsyncResult* result, gpointer data);
+  static void inhibit_cb (GObject* source, GAsyncResult* result, gpointer data);
+  static void uninhibit_cb (GObject* source, GAsyncResult* result, gpointer data);
+
   GDBusProxy* proxy_ = nullptr;
+  GCancellable* cancellable_ = nullptr;
   guint32 cookie_ = 0;
+  bool want_inhibit_ = false;
+  bool proxy_requested_ = false;
+  bool proxy_failed_ = false;
+  bool call_pending_ = false;
 };
 
 }
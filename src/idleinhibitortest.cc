@@ -0,0 +1,238 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* checks IdleInhibitor against a fake org.freedesktop.ScreenSaver service;
+ * needs a session bus, so run it via "dbus-run-session -- ./idleinhibitortest"
+ */
+
+#include "idleinhibitor.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace Gst123;
+
+namespace
+{
+
+const guint32 COOKIE = 42;
+
+const char *introspection_xml =
+  "<node>"
+  "  <interface name='org.freedesktop.ScreenSaver'>"
+  "    <method name='Inhibit'>"
+  "      <arg type='s' name='application_name' direction='in'/>"
+  "      <arg type='s' name='reason_for_inhibit' direction='in'/>"
+  "      <arg type='u' name='cookie' direction='out'/>"
+  "    </method>"
+  "    <method name='UnInhibit'>"
+  "      <arg type='u' name='cookie' direction='in'/>"
+  "    </method>"
+  "  </interface>"
+  "</node>";
+
+/* the service runs in its own thread with its own bus connection, so that it
+ * can answer while the main thread blocks in uninhibit_sync()
+ */
+struct FakeScreenSaver
+{
+  GMutex      mutex;
+  GCond       cond;
+  bool        name_acquired;   // protected by mutex
+  bool        inhibited;       // protected by mutex
+  GMainLoop  *loop;            // set before the name is acquired
+  GThread    *thread;
+
+  FakeScreenSaver() :
+    name_acquired (false),
+    inhibited (false),
+    loop (NULL),
+    thread (NULL)
+  {
+    g_mutex_init (&mutex);
+    g_cond_init (&cond);
+  }
+
+  bool
+  is_inhibited()
+  {
+    g_mutex_lock (&mutex);
+    bool result = inhibited;
+    g_mutex_unlock (&mutex);
+
+    return result;
+  }
+
+  static void
+  method_call (GDBusConnection *connection, const gchar *sender, const gchar *object_path,
+               const gchar *interface_name, const gchar *method_name, GVariant *parameters,
+               GDBusMethodInvocation *invocation, gpointer user_data)
+  {
+    FakeScreenSaver *self = static_cast<FakeScreenSaver *> (user_data);
+
+    if (g_str_equal (method_name, "Inhibit"))
+      {
+        g_mutex_lock (&self->mutex);
+        self->inhibited = true;
+        g_mutex_unlock (&self->mutex);
+
+        g_dbus_method_invocation_return_value (invocation, g_variant_new ("(u)", COOKIE));
+      }
+    else
+      {
+        guint32 cookie;
+        g_variant_get (parameters, "(u)", &cookie);
+
+        g_mutex_lock (&self->mutex);
+        if (cookie == COOKIE)
+          self->inhibited = false;
+        g_mutex_unlock (&self->mutex);
+
+        g_dbus_method_invocation_return_value (invocation, NULL);
+      }
+  }
+
+  static void
+  name_acquired_cb (GDBusConnection *connection, const gchar *name, gpointer user_data)
+  {
+    FakeScreenSaver *self = static_cast<FakeScreenSaver *> (user_data);
+
+    g_mutex_lock (&self->mutex);
+    self->name_acquired = true;
+    g_cond_signal (&self->cond);
+    g_mutex_unlock (&self->mutex);
+  }
+
+  static gpointer
+  thread_func (gpointer data)
+  {
+    FakeScreenSaver *self = static_cast<FakeScreenSaver *> (data);
+
+    GMainContext *context = g_main_context_new();
+    g_main_context_push_thread_default (context);
+
+    GError *error = NULL;
+    char *address = g_dbus_address_get_for_bus_sync (G_BUS_TYPE_SESSION, NULL, &error);
+    GDBusConnection *connection = NULL;
+    if (address)
+      {
+        GDBusConnectionFlags flags = GDBusConnectionFlags (G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                                                           G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION);
+        connection = g_dbus_connection_new_for_address_sync (address, flags, NULL, NULL, &error);
+        g_free (address);
+      }
+    if (!connection)
+      {
+        fprintf (stderr, "idleinhibitortest: no session bus: %s\n", error->message);
+        exit (77); // skipped
+      }
+
+    self->loop = g_main_loop_new (context, FALSE);
+
+    GDBusNodeInfo *node_info = g_dbus_node_info_new_for_xml (introspection_xml, NULL);
+    GDBusInterfaceVTable vtable = { method_call, NULL, NULL };
+    g_dbus_connection_register_object (connection, "/org/freedesktop/ScreenSaver", node_info->interfaces[0],
+                                       &vtable, self, NULL, NULL);
+    guint owner_id = g_bus_own_name_on_connection (connection, "org.freedesktop.ScreenSaver",
+                                                   G_BUS_NAME_OWNER_FLAGS_NONE, name_acquired_cb, NULL,
+                                                   self, NULL);
+    g_main_loop_run (self->loop);
+
+    g_bus_unown_name (owner_id);
+    g_main_loop_unref (self->loop);
+    g_dbus_node_info_unref (node_info);
+    g_object_unref (connection);
+    g_main_context_pop_thread_default (context);
+    g_main_context_unref (context);
+    return NULL;
+  }
+
+  void
+  start()
+  {
+    thread = g_thread_new ("fake-screensaver", thread_func, this);
+
+    g_mutex_lock (&mutex);
+    while (!name_acquired)
+      g_cond_wait (&cond, &mutex);
+    g_mutex_unlock (&mutex);
+  }
+
+  void
+  stop()
+  {
+    g_main_loop_quit (loop);
+    g_thread_join (thread);
+  }
+};
+
+/* runs the main loop (which completes the async calls) until check() is true */
+template<class Check> bool
+iterate_until (Check check)
+{
+  gint64 end_time = g_get_monotonic_time() + 5 * G_TIME_SPAN_SECOND;
+
+  while (!check() && g_get_monotonic_time() < end_time)
+    g_main_context_iteration (NULL, FALSE);
+
+  return check();
+}
+
+int failed = 0;
+
+void
+expect (bool condition, const char *what)
+{
+  if (!condition)
+    {
+      fprintf (stderr, "idleinhibitortest: FAILED: %s\n", what);
+      failed++;
+    }
+}
+
+}
+
+int
+main()
+{
+  FakeScreenSaver service;
+  service.start();
+
+  {
+    IdleInhibitor inhibitor;
+
+    inhibitor.inhibit();
+    expect (iterate_until ([&] { return inhibitor.is_inhibited(); }), "inhibit");
+    expect (service.is_inhibited(), "service sees inhibit");
+
+    inhibitor.uninhibit();
+    expect (iterate_until ([&] { return !service.is_inhibited(); }), "async uninhibit");
+
+    inhibitor.inhibit();
+    expect (iterate_until ([&] { return inhibitor.is_inhibited(); }), "inhibit again");
+
+    /* like on exit: no more main loop iterations after this */
+    inhibitor.uninhibit_sync (500);
+    expect (!inhibitor.is_inhibited(), "uninhibit_sync cookie");
+    expect (!service.is_inhibited(), "service sees uninhibit_sync");
+  }
+
+  service.stop();
+  return failed ? 1 : 0;
+}
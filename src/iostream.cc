@@ -112,14 +112,78 @@ IOStream::readline (const string& newline)
   return curline.length();
 }
 
-/* Look for a specific pattern in the first line of content */
-bool
-IOStream::content_begins_with (const string& match)
+/*
+ * Read the next chunk of input, without splitting it into lines; this is
+ * for formats that don't depend on line breaks (XML, JSON) and may not even
+ * contain any. Input which was already read by readline() but not returned
+ * as a line is returned first.
+ *
+ * Returns length of the data read
+ */
+int
+IOStream::read_data (string& data)
+{
+  if (strbuf != "")
+    {
+      data = strbuf;
+      strbuf = "";
+      bof = false;
+      return data.length();
+    }
+  if (eof)
+    return (status = IO_STREAM_EOF);
+
+  char buf [4096];
+  int len = read (fd, buf, sizeof (buf));
+
+  if (len < 0)
+    {
+      cerr << "Read error on fd " << fd
+           << ": " << strerror (errno) << endl;
+      status = errno;
+      return -status;
+    }
+  if (len == 0)
+    {
+      eof = true;
+      return (status = IO_STREAM_EOF);
+    }
+
+  data.assign (buf, len);
+  bof = false;
+  return len;
+}
+
+/* true if data contains a complete line which is not blank */
+static bool
+has_content_line (const string& data)
 {
-  if (bof)
-    readline();
+  size_t content = data.find_first_not_of (" \t\r\n\f");
+  return content != string::npos && data.find ('\n', content) != string::npos;
+}
 
-  return (curline.find (match) == 0);
+/*
+ * Returns the input which has not been read yet, without consuming it; reads
+ * until it contains the first non-blank line, len bytes or the end of file,
+ * so that a slow source (pipe, network) which already sent the first line
+ * doesn't block us
+ */
+const string&
+IOStream::peek_line (size_t len)
+{
+  char buf [4096];
+
+  while (strbuf.size() < len && !eof && !has_content_line (strbuf))
+    {
+      int n = read (fd, buf, sizeof (buf));
+      if (n == 0)
+        eof = true;
+      if (n <= 0)
+        break;  // errors are reported by the next readline()/read_data()
+
+      strbuf.append (buf, n);
+    }
+  return strbuf;
 }
 
 std::string&
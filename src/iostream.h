@@ -62,7 +62,8 @@ public:
   virtual ~IOStream();
 
   int readline (const std::string& separator = "\n");
-  bool content_begins_with (const std::string& magic);
+  int read_data (std::string& data);
+  const std::string& peek_line (size_t len);
   virtual std::string get_content_type();
   std::string& get_current_line();
 
@@ -0,0 +1,405 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "jspfparser.h"
+#include <glib.h>
+#include <errno.h>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+using namespace Gst123;
+
+/*
+ * JSON reader: the tokenizer keeps only the current token and a stack of
+ * open objects/arrays; track objects are found by their position
+ *
+ *   { "playlist": { "track": [ { "location": [...], "title": ..., "duration": ... } ] } }
+ */
+class JSPFReader
+{
+  enum TokenState { NONE, STRING, ESCAPE, UNICODE, NUMBER, LITERAL };
+
+  struct Frame
+  {
+    bool   is_object;
+    bool   expect_key;
+    string key;
+  };
+
+  PlaylistEntryHandler& output;
+
+  TokenState    token_state;
+  string        token;
+  string        unicode_hex;
+  gunichar      high_surrogate;
+  vector<Frame> frames;
+
+  PlaylistEntry entry;
+  bool          have_location;
+  bool          have_playlist;
+
+  bool
+  in_track_object()
+  {
+    return frames.size() >= 4 &&
+           frames[0].is_object && frames[0].key == "playlist" &&
+           frames[1].is_object && frames[1].key == "track" &&
+           !frames[2].is_object && frames[3].is_object;
+  }
+
+  bool
+  begin_container (bool is_object)
+  {
+    if (frames.empty() && !is_object)
+      return false;
+
+    Frame frame;
+    frame.is_object = is_object;
+    frame.expect_key = is_object;
+    frames.push_back (frame);
+
+    if (frames.size() == 2 && frames[0].key == "playlist" && is_object)
+      have_playlist = true;
+
+    if (frames.size() == 4 && in_track_object())
+      {
+        entry = PlaylistEntry();
+        have_location = false;
+      }
+    return true;
+  }
+
+  bool
+  end_container (bool is_object)
+  {
+    if (frames.empty() || frames.back().is_object != is_object)
+      return false;
+
+    if (frames.size() == 4 && in_track_object() && have_location)
+      output.add_entry (entry);
+
+    frames.pop_back();
+    return true;
+  }
+
+  void
+  string_value (const string& value)
+  {
+    if (frames.size() == 4 && in_track_object())
+      {
+        const string& key = frames[3].key;
+        if (key == "title")
+          entry.title = value;
+        else if (key == "location" && !have_location)
+          {
+            entry.location = PlaylistParser::location_from_uri_reference (value);
+            have_location = value != "";
+          }
+      }
+    /* "location" is an array of alternative locations, we use the first one */
+    else if (frames.size() == 5 && !frames[4].is_object && frames[3].key == "location" && in_track_object())
+      {
+        if (!have_location)
+          {
+            entry.location = PlaylistParser::location_from_uri_reference (value);
+            have_location = value != "";
+          }
+      }
+  }
+
+  void
+  number_value (double value)
+  {
+    if (frames.size() == 4 && in_track_object() && frames[3].key == "duration" && value > 0)
+      entry.duration = value / 1000;  // milliseconds
+  }
+
+  bool
+  string_token (const string& str)
+  {
+    if (frames.empty())
+      return false;
+
+    Frame& frame = frames.back();
+    if (frame.is_object && frame.expect_key)
+      {
+        frame.key = str;
+        frame.expect_key = false;
+      }
+    else
+      {
+        string_value (str);
+      }
+    return true;
+  }
+
+  void
+  append_unicode (gunichar c)
+  {
+    char buffer[8];
+    int len = g_unichar_to_utf8 (c, buffer);
+    token.append (buffer, len);
+  }
+
+  bool
+  process_escape (char c)
+  {
+    switch (c)
+      {
+        case '"':  token += '"';  break;
+        case '\\': token += '\\'; break;
+        case '/':  token += '/';  break;
+        case 'b':  token += '\b'; break;
+        case 'f':  token += '\f'; break;
+        case 'n':  token += '\n'; break;
+        case 'r':  token += '\r'; break;
+        case 't':  token += '\t'; break;
+        case 'u':
+          unicode_hex = "";
+          token_state = UNICODE;
+          return true;
+        default:
+          return false;
+      }
+    token_state = STRING;
+    return true;
+  }
+
+  bool
+  process_unicode (char c)
+  {
+    if (!g_ascii_isxdigit (c))
+      return false;
+
+    unicode_hex += c;
+    if (unicode_hex.size() < 4)
+      return true;
+
+    gunichar u = g_ascii_strtoull (unicode_hex.c_str(), NULL, 16);
+    if (u >= 0xd800 && u < 0xdc00)          // high surrogate: wait for the low surrogate
+      {
+        high_surrogate = u;
+      }
+    else if (u >= 0xdc00 && u < 0xe000)     // low surrogate
+      {
+        if (high_surrogate)
+          append_unicode (0x10000 + ((high_surrogate - 0xd800) << 10) + (u - 0xdc00));
+        high_surrogate = 0;
+      }
+    else
+      {
+        append_unicode (u);
+        high_surrogate = 0;
+      }
+    token_state = STRING;
+    return true;
+  }
+
+  bool
+  end_token()
+  {
+    if (token_state == NUMBER)
+      {
+        token_state = NONE;
+        if (frames.empty())
+          return false;
+
+        number_value (g_ascii_strtod (token.c_str(), NULL));
+      }
+    else if (token_state == LITERAL)
+      {
+        token_state = NONE;
+        if (frames.empty() || (token != "true" && token != "false" && token != "null"))
+          return false;
+      }
+    return true;
+  }
+
+public:
+  JSPFReader (PlaylistEntryHandler& output) :
+    output (output),
+    token_state (NONE),
+    high_surrogate (0),
+    have_location (false),
+    have_playlist (false)
+  {
+  }
+
+  bool
+  process (const string& data)
+  {
+    for (size_t i = 0; i < data.size(); i++)
+      {
+        char c = data[i];
+
+        switch (token_state)
+          {
+            case STRING:
+              if (c == '\\')
+                token_state = ESCAPE;
+              else if (c == '"')
+                {
+                  token_state = NONE;
+                  if (!string_token (token))
+                    return false;
+                }
+              else
+                token += c;
+              continue;
+            case ESCAPE:
+              if (!process_escape (c))
+                return false;
+              continue;
+            case UNICODE:
+              if (!process_unicode (c))
+                return false;
+              continue;
+            case NUMBER:
+              if (g_ascii_isdigit (c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E')
+                {
+                  token += c;
+                  continue;
+                }
+              if (!end_token())
+                return false;
+              break;  // c needs to be processed as start of the next token
+            case LITERAL:
+              if (g_ascii_isalpha (c))
+                {
+                  token += c;
+                  continue;
+                }
+              if (!end_token())
+                return false;
+              break;  // c needs to be processed as start of the next token
+            case NONE:
+              break;
+          }
+
+        if (g_ascii_isspace (c) || c == ':')
+          continue;
+
+        bool ok = true;
+        if (c == '{' || c == '[')
+          ok = begin_container (c == '{');
+        else if (c == '}' || c == ']')
+          ok = end_container (c == '}');
+        else if (c == ',')
+          {
+            if (!frames.empty() && frames.back().is_object)
+              frames.back().expect_key = true;
+          }
+        else if (c == '"')
+          {
+            token = "";
+            token_state = STRING;
+          }
+        else if (g_ascii_isdigit (c) || c == '-')
+          {
+            token = c;
+            token_state = NUMBER;
+          }
+        else if (g_ascii_isalpha (c))
+          {
+            token = c;
+            token_state = LITERAL;
+          }
+        else
+          ok = false;
+
+        if (!ok)
+          return false;
+      }
+    return true;
+  }
+
+  bool
+  finish()
+  {
+    return end_token() && token_state == NONE && frames.empty();
+  }
+
+  bool
+  found_playlist() const
+  {
+    return have_playlist;
+  }
+};
+
+static const char * const jspf_content_types[] = { "application/jspf+json", NULL };
+
+// other JSON files are rejected while parsing (if they have no "playlist" object)
+static const char * const jspf_magics[] = { "{", NULL };
+
+const PlaylistFormat&
+JSPFParser::format()
+{
+  static const PlaylistFormat jspf_format = { jspf_content_types, jspf_magics, false };
+  return jspf_format;
+}
+
+int
+JSPFParser::parse (PlaylistEntryHandler& output, IOStream *stream)
+{
+  JSPFReader reader (output);
+  int ret = 0;
+
+  string data;
+  bool ok = true;
+  bool first_data = true;
+  while (ok && (ret = stream->read_data (data)) >= 0)
+    {
+      if (first_data && data.compare (0, 3, "\xef\xbb\xbf") == 0)
+        data.erase (0, 3);
+      if (!data.empty())
+        first_data = false;
+
+      ok = reader.process (data);
+    }
+
+  if (ok && ret == IO_STREAM_EOF)
+    ok = reader.finish();
+
+  if (!ok)
+    return JSPF_ERROR_SYNTAX;
+
+  if (ret == IO_STREAM_EOF)  // EOF is not an error
+    ret = 0;
+
+  if (ret < 0)
+    ret = errno;
+
+  if (ret == 0 && !reader.found_playlist())
+    return JSPF_ERROR_NOT_JSPF;
+
+  return ret;
+}
+
+string
+JSPFParser::str_error (int error)
+{
+  if (error == JSPF_ERROR_NOT_JSPF)
+    return "JSON file is not a JSPF playlist";
+  if (error == JSPF_ERROR_SYNTAX)
+    return "JSPF parse error: invalid JSON";
+  return "";
+}
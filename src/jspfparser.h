@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __JSPF_PARSER_H__
+#define __JSPF_PARSER_H__
+
+#include "playlist.h"
+
+namespace Gst123
+{
+
+enum
+{
+  JSPF_ERROR_SYNTAX     = 1100,
+  JSPF_ERROR_NOT_JSPF   = 1101
+};
+
+/*
+ * JSPF (XSPF as JSON) playlist parser
+ *
+ * Uses a small incremental JSON tokenizer, so the input can be processed in
+ * chunks (JSPF files are often a single line); each track is passed on as
+ * soon as its object is complete.
+ */
+struct JSPFParser : public PlaylistParser
+{
+  int parse (PlaylistEntryHandler& output, IOStream *stream);
+  const PlaylistFormat& format();
+  std::string str_error (int error);
+};
+
+}
+
+#endif
@@ -0,0 +1,486 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+#include "library.h"
+#include "configfile.h"
+#include "uriresolver.h"
+#include "metadatastore.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <set>
+
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
+
+using std::string;
+using std::vector;
+using std::map;
+using std::set;
+
+namespace Gst123
+{
+
+static const char *INDEX_HEADER = "gst123 library index 2";
+
+static Library *instance = NULL;
+
+/* absolute path without trailing slashes, "~/" is the home directory */
+static string
+normalize (const string& path)
+{
+  string result;
+
+  if (path.compare (0, 2, "~/") == 0)
+    result = UriResolver::join_path (g_get_home_dir(), path.substr (2));
+  else
+    result = UriResolver::absolute_path (path);
+
+  while (result.size() > 1 && result[result.size() - 1] == G_DIR_SEPARATOR)
+    result.resize (result.size() - 1);
+  return result;
+}
+
+Library::Dir::Dir() :
+  mtime (-1),
+  scan_time (0),
+  watch (-1),
+  stale (false)
+{
+}
+
+Library&
+Library::the()
+{
+  if (!instance)
+    instance = new Library();
+
+  return *instance;
+}
+
+Library::Library() :
+  loaded (false),
+  dirty (false),
+  metadata_changes (0),
+  inotify_fd (-1),
+  inotify_watch_id (0)
+{
+  const vector<string>& library_dirs = ConfigFile::the().library_dirs();
+  for (vector<string>::const_iterator li = library_dirs.begin(); li != library_dirs.end(); li++)
+    roots.push_back (normalize (*li));
+
+#ifdef HAVE_SYS_INOTIFY_H
+  if (!roots.empty())
+    {
+      inotify_fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+      if (inotify_fd >= 0)
+        {
+          GIOChannel *channel = g_io_channel_unix_new (inotify_fd);
+          inotify_watch_id = g_io_add_watch (channel, G_IO_IN, inotify_cb, this);
+          g_io_channel_unref (channel);
+        }
+    }
+#endif
+}
+
+string
+Library::index_filename() const
+{
+  return UriResolver::join_path (UriResolver::join_path (g_get_user_cache_dir(), "gst123"), "library");
+}
+
+bool
+Library::contains (const string& path) const
+{
+  if (roots.empty())
+    return false;
+
+  string abs_path = normalize (path);
+  for (vector<string>::const_iterator ri = roots.begin(); ri != roots.end(); ri++)
+    {
+      if (abs_path == *ri)
+        return true;
+
+      string prefix = UriResolver::join_path (*ri, "");
+      if (abs_path.compare (0, prefix.size(), prefix) == 0)
+        return true;
+    }
+  return false;
+}
+
+/* parses the part after "M " of a metadata record and adds it to the MetadataStore */
+static void
+load_metadata (const string& uri, const char *record)
+{
+  char **fields = g_strsplit (record, "\t", 4);
+  if (g_strv_length (fields) == 4)
+    {
+      MetadataStore::Entry entry;
+      char *end = NULL;
+
+      entry.mtime = g_ascii_strtoll (fields[0], &end, 10);
+      if (end != fields[0] && *end == ' ')
+        {
+          entry.metadata.duration = g_ascii_strtod (end + 1, NULL);
+
+          string *values[3] = { &entry.metadata.title, &entry.metadata.artist, &entry.metadata.album };
+          for (int i = 0; i < 3; i++)
+            {
+              char *value = g_strcompress (fields[i + 1]);
+              *values[i] = value;
+              g_free (value);
+            }
+          MetadataStore::the().restore (uri, entry);
+        }
+    }
+  g_strfreev (fields);
+}
+
+/* metadata record for a file, or "" if the MetadataStore doesn't know it */
+static string
+metadata_record (const string& uri)
+{
+  MetadataStore::Entry entry;
+  if (!MetadataStore::the().lookup (uri, entry))
+    return "";
+
+  char duration[G_ASCII_DTOSTR_BUF_SIZE];
+  string record = "M " + std::to_string (entry.mtime) + " " + g_ascii_dtostr (duration, sizeof (duration), entry.metadata.duration);
+
+  const string *values[3] = { &entry.metadata.title, &entry.metadata.artist, &entry.metadata.album };
+  for (int i = 0; i < 3; i++)
+    {
+      char *value = g_strescape (values[i]->c_str(), NULL);
+      record += '\t';
+      record += value;
+      g_free (value);
+    }
+  return record + "\n";
+}
+
+/* index file format (one record per line, paths and names escaped with g_strescape()):
+ *
+ *   D <mtime> <scan time> <directory path>
+ *   F <file name>
+ *   M <file mtime> <duration>\t<title>\t<artist>\t<album>   (metadata of the file before)
+ *   S <subdirectory name>
+ */
+void
+Library::load()
+{
+  loaded = true;
+
+  char *contents = NULL;
+  if (!g_file_get_contents (index_filename().c_str(), &contents, NULL, NULL))
+    return;   // no index yet
+
+  char **lines = g_strsplit (contents, "\n", -1);
+  g_free (contents);
+
+  if (lines[0] && strcmp (lines[0], INDEX_HEADER) == 0)
+    {
+      Dir   *dir = NULL;
+      string dir_path;
+      string file_uri;   // uri of the last file, for metadata records
+
+      for (char **line = lines + 1; *line; line++)
+        {
+          char type = (*line)[0];
+          if (type != 'M')
+            file_uri = "";
+
+          if (type == 'D')
+            {
+              gint64 mtime, scan_time;
+              int    offset = 0;
+
+              dir = NULL;
+              if (sscanf (*line, "D %" G_GINT64_FORMAT " %" G_GINT64_FORMAT " %n", &mtime, &scan_time, &offset) == 2 && offset > 0)
+                {
+                  char *path = g_strcompress (*line + offset);
+                  if (contains (path))
+                    {
+                      dir = &dirs[path];
+                      dir_path = path;
+                      dir->mtime = mtime;
+                      dir->scan_time = scan_time;
+                    }
+                  g_free (path);
+                }
+            }
+          else if ((type == 'F' || type == 'S') && (*line)[1] == ' ' && dir)
+            {
+              char *name = g_strcompress (*line + 2);
+
+              Entry entry;
+              entry.name = name;
+              entry.is_dir = (type == 'S');
+              dir->entries.push_back (entry);
+              g_free (name);
+
+              if (!entry.is_dir)
+                file_uri = UriResolver::file_uri (UriResolver::join_path (dir_path, entry.name));
+            }
+          else if (type == 'M' && (*line)[1] == ' ' && file_uri != "")
+            {
+              load_metadata (file_uri, *line + 2);
+            }
+        }
+    }
+  g_strfreev (lines);
+}
+
+void
+Library::save()
+{
+  /* discovery may have found metadata for files in the index */
+  guint changes = MetadataStore::the().changes();
+  if (!loaded || (!dirty && changes == metadata_changes))
+    return;
+
+  string index = INDEX_HEADER;
+  index += '\n';
+  for (map<string, Dir>::const_iterator di = dirs.begin(); di != dirs.end(); di++)
+    {
+      const Dir& dir = di->second;
+      if (dir.scan_time == 0)
+        continue;
+
+      char *path = g_strescape (di->first.c_str(), NULL);
+      index += "D " + std::to_string (dir.mtime) + " " + std::to_string (dir.scan_time) + " " + path + "\n";
+      g_free (path);
+
+      for (vector<Entry>::const_iterator ei = dir.entries.begin(); ei != dir.entries.end(); ei++)
+        {
+          char *name = g_strescape (ei->name.c_str(), NULL);
+          index += ei->is_dir ? "S " : "F ";
+          index += name;
+          index += '\n';
+          g_free (name);
+
+          if (!ei->is_dir)
+            index += metadata_record (UriResolver::file_uri (UriResolver::join_path (di->first, ei->name)));
+        }
+    }
+
+  /* the index is only a cache, so we don't complain if it can't be written */
+  string filename = index_filename();
+  char *dirname = g_path_get_dirname (filename.c_str());
+  g_mkdir_with_parents (dirname, 0700);
+  g_free (dirname);
+
+  if (g_file_set_contents (filename.c_str(), index.c_str(), index.size(), NULL))
+    {
+      dirty = false;
+      metadata_changes = changes;
+    }
+}
+
+/* removes a directory and its subdirectories from the index */
+void
+Library::forget (const string& path)
+{
+  string prefix = UriResolver::join_path (path, "");
+
+  map<string, Dir>::iterator di = dirs.find (path);
+  if (di != dirs.end())
+    forget_dir (di);
+
+  di = dirs.lower_bound (prefix);
+  while (di != dirs.end() && di->first.compare (0, prefix.size(), prefix) == 0)
+    forget_dir (di++);
+
+  dirty = true;
+}
+
+void
+Library::forget_dir (map<string, Dir>::iterator di)
+{
+#ifdef HAVE_SYS_INOTIFY_H
+  if (di->second.watch >= 0)
+    {
+      inotify_rm_watch (inotify_fd, di->second.watch);
+      watches.erase (di->second.watch);
+    }
+#endif
+  dirs.erase (di);
+}
+
+void
+Library::add_watch (const string& path, Dir& dir)
+{
+#ifdef HAVE_SYS_INOTIFY_H
+  if (inotify_fd < 0 || dir.watch >= 0)
+    return;
+
+  /* if we run out of watches, we just need to stat() the directory */
+  int wd = inotify_add_watch (inotify_fd, path.c_str(),
+                              IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                              IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+  if (wd >= 0)
+    {
+      dir.watch = wd;
+      watches[wd] = path;
+    }
+#endif
+}
+
+gboolean
+Library::inotify_cb (GIOChannel *source, GIOCondition condition, gpointer data)
+{
+#ifdef HAVE_SYS_INOTIFY_H
+  Library *self = static_cast<Library *> (data);
+  char buffer[4096] __attribute__ ((aligned (__alignof__ (struct inotify_event))));
+  ssize_t len;
+
+  while ((len = read (self->inotify_fd, buffer, sizeof (buffer))) > 0)
+    {
+      for (char *ptr = buffer; ptr < buffer + len; ptr += sizeof (struct inotify_event) + ((struct inotify_event *) ptr)->len)
+        {
+          const struct inotify_event *event = (const struct inotify_event *) ptr;
+
+          if (event->mask & IN_Q_OVERFLOW)
+            {
+              /* we lost events, so every directory needs to be checked */
+              for (map<string, Dir>::iterator di = self->dirs.begin(); di != self->dirs.end(); di++)
+                di->second.stale = true;
+              continue;
+            }
+
+          map<int, string>::iterator wi = self->watches.find (event->wd);
+          if (wi == self->watches.end())
+            continue;
+
+          map<string, Dir>::iterator di = self->dirs.find (wi->second);
+          if (di != self->dirs.end())
+            {
+              di->second.stale = true;
+              if (event->mask & IN_IGNORED)   // watch was removed by the kernel
+                di->second.watch = -1;
+            }
+          if (event->mask & IN_IGNORED)
+            self->watches.erase (wi);
+        }
+    }
+#endif
+  return TRUE;
+}
+
+/* returns the directory, with entries that are up-to-date, or NULL if it doesn't exist */
+Library::Dir *
+Library::update (const string& path)
+{
+  map<string, Dir>::iterator di = dirs.find (path);
+  if (di != dirs.end() && di->second.watch >= 0 && !di->second.stale)
+    return &di->second;   // inotify didn't report any change
+
+  struct stat st;
+  if (stat (path.c_str(), &st) != 0 || !S_ISDIR (st.st_mode))
+    {
+      if (di != dirs.end())
+        forget (path);
+      return NULL;
+    }
+
+  Dir& dir = dirs[path];
+  add_watch (path, dir);
+
+  /* the mtime has a resolution of one second: if the directory was modified in
+   * the second we read it, we could have missed a later change in the same second
+   */
+  if (!dir.stale && dir.scan_time > 0 && dir.mtime == st.st_mtime && dir.mtime < dir.scan_time)
+    return &dir;
+
+  /* the watch is active now, so changes while reading the directory will mark it stale again */
+  dir.stale = false;
+  dir.mtime = st.st_mtime;
+  dir.scan_time = g_get_real_time() / G_USEC_PER_SEC;
+
+  vector<Entry> old_entries;
+  old_entries.swap (dir.entries);
+
+  set<string> subdirs;
+  GDir *gdir = g_dir_open (path.c_str(), 0, NULL);
+  if (gdir)
+    {
+      const char *name;
+
+      while ((name = g_dir_read_name (gdir)))
+        {
+          /* same rules as crawl() */
+          FileInfo finfo = UriResolver::file_info (UriResolver::join_path (path, name));
+          if (finfo == FI_DIR || finfo == FI_REG)
+            {
+              Entry entry;
+              entry.name = name;
+              entry.is_dir = (finfo == FI_DIR);
+              dir.entries.push_back (entry);
+
+              if (entry.is_dir)
+                subdirs.insert (name);
+            }
+        }
+      g_dir_close (gdir);
+    }
+
+  /* subdirectories which are gone */
+  for (vector<Entry>::const_iterator ei = old_entries.begin(); ei != old_entries.end(); ei++)
+    {
+      if (ei->is_dir && !subdirs.count (ei->name))
+        forget (UriResolver::join_path (path, ei->name));
+    }
+  dirty = true;
+  return &dir;
+}
+
+void
+Library::collect (const string& path, vector<string>& files)
+{
+  Dir *dir = update (path);
+  if (!dir)
+    return;
+
+  for (vector<Entry>::const_iterator ei = dir->entries.begin(); ei != dir->entries.end(); ei++)
+    {
+      string full_name = UriResolver::join_path (path, ei->name);
+      if (ei->is_dir)
+        collect (full_name, files);
+      else
+        files.push_back (full_name);
+    }
+}
+
+/* all files in the directory and its subdirectories, like crawl() */
+vector<string>
+Library::files (const string& path)
+{
+  if (!loaded)
+    load();
+
+  vector<string> result;
+  collect (normalize (path), result);
+  return result;
+}
+
+}
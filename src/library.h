@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef GST123_LIBRARY_H
+#define GST123_LIBRARY_H
+
+#include <glib.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Gst123
+{
+
+/*
+ * Persistent index of the library directories (library <dir> in the config file)
+ *
+ * For each directory, the index stores its entries (regular files and
+ * subdirectories) and its modification time. Creating, removing or renaming
+ * a file changes the modification time of its directory, so directories
+ * whose mtime didn't change are taken from the index: looking up a library
+ * directory costs one stat() per directory instead of reading all
+ * directories and stat()ing every file (see crawl()).
+ *
+ * Directories which were checked are watched with inotify while gst123
+ * runs, so checking them again (for instance in --lazy mode) doesn't need
+ * any system call unless they changed. The index also contains the
+ * durations and tags of the files from the MetadataStore, so discovery
+ * doesn't need to probe them again. It is stored in ~/.cache/gst123/library.
+ */
+class Library
+{
+  struct Entry
+  {
+    std::string name;
+    bool        is_dir;
+  };
+  struct Dir
+  {
+    gint64              mtime;       // seconds
+    gint64              scan_time;   // when the entries were read (seconds)
+    std::vector<Entry>  entries;
+    int                 watch;       // inotify watch descriptor, -1 if not watched
+    bool                stale;       // inotify reported changes
+
+    Dir();
+  };
+  std::vector<std::string>      roots;
+  std::map<std::string, Dir>    dirs;       // indexed by absolute path
+  std::map<int, std::string>    watches;    // inotify watch descriptor -> path
+  bool                          loaded;
+  bool                          dirty;
+  guint                         metadata_changes;   // MetadataStore::changes() when the index was written
+  int                           inotify_fd;
+  guint                         inotify_watch_id;
+
+  Library();
+
+  std::string index_filename() const;
+  void load();
+  Dir *update (const std::string& path);
+  void collect (const std::string& path, std::vector<std::string>& files);
+  void add_watch (const std::string& path, Dir& dir);
+  void forget (const std::string& path);
+  void forget_dir (std::map<std::string, Dir>::iterator di);
+
+  static gboolean inotify_cb (GIOChannel *source, GIOCondition condition, gpointer data);
+
+public:
+  static Library& the();   // Singleton
+
+  bool contains (const std::string& path) const;
+  std::vector<std::string> files (const std::string& path);
+  void save();
+};
+
+}
+
+#endif
@@ -22,38 +22,62 @@
 #include <ctype.h>
 #include <cstring>
 #include <errno.h>
+#include <glib.h>
 
 using std::string;
 using std::vector;
 
 using namespace Gst123;
 
-// Identify if the playlist is M3U
-bool
-M3UParser::identify (IOStream *stream)
+static const char * const m3u_content_types[] = { "audio/x-mpegurl", "audio/mpegurl", NULL };
+static const char * const m3u_magics[] = { "#EXTM3U", NULL };
+
+// M3U is the fallback: the format is simply one entry per line
+const PlaylistFormat&
+M3UParser::format()
 {
-  // Trust the content type first
-  if (stream->get_content_type() == "audio/x-mpegurl" || stream->get_content_type() == "audio/mpegurl")
-    return true;
-  else if (stream->get_content_type() != "")
-    return false;
-
-  if (stream->content_begins_with ("#EXTM3U"))
-    extended = true;
-  else
-    extended = false;
-
-  return true;
+  static const PlaylistFormat m3u_format = { m3u_content_types, m3u_magics, true };
+  return m3u_format;
 }
 ;
+/* parses "#EXTINF:<seconds>[ <attributes>],<title>" */
+static void
+parse_extinf (const string& line, PlaylistEntry& entry)
+{
+  const char *info = line.c_str() + strlen ("#EXTINF:");
+  char *end;
+
+  double duration = g_ascii_strtod (info, &end);
+  if (end != info && duration > 0)   // -1 is used for "unknown" (i.e. streams)
+    entry.duration = duration;
+
+  // the title starts after the first comma which is not part of a quoted attribute value
+  bool quoted = false;
+  for (const char *p = end; *p; p++)
+    {
+      if (*p == '"')
+        quoted = !quoted;
+      else if (*p == ',' && !quoted)
+        {
+          string title = p + 1;
+          while (!title.empty() && isspace (title[0]))
+            title.erase (0, 1);
+          while (!title.empty() && isspace (title[title.size() - 1]))
+            title.erase (title.size() - 1);
+          entry.title = title;
+          break;
+        }
+    }
+}
+
 // Parse the playlist
-// Currently we are only picking out the file to be played
-// and we don't really care about the playlist entry information
-// such as the title, artist, etc.
+// Besides the file to be played, we pick out the title and duration
+// of each entry (if available)
 int
-M3UParser::parse (vector<string>& list, IOStream *stream)
+M3UParser::parse (PlaylistEntryHandler& output, IOStream *stream)
 {
   int ret = 0;
+  PlaylistEntry info;   // from the last #EXTINF line, applies to the next entry
 
   do
     {
@@ -65,9 +89,18 @@ M3UParser::parse (vector<string>& list, IOStream *stream)
       while (!curline.empty() && isspace (curline[0]))
         curline.erase (0, 1);
 
+      if (curline.compare (0, 8, "#EXTINF:") == 0)
+        {
+          info = PlaylistEntry();
+          parse_extinf (curline, info);
+        }
       // Avoid comments
-      if (!curline.empty() && curline[0] != '#')
-        list.push_back (curline);
+      else if (!curline.empty() && curline[0] != '#')
+        {
+          info.location = curline;
+          output.add_entry (info);
+          info = PlaylistEntry();
+        }
     }
   while ((ret = stream->readline()) >= 0);
 
@@ -28,11 +28,9 @@ namespace Gst123
 
 struct M3UParser : public PlaylistParser
 {
-  int parse (std::vector<std::string>& list, IOStream *stream);
-  bool identify (IOStream *stream);
+  int parse (PlaylistEntryHandler& output, IOStream *stream);
+  const PlaylistFormat& format();
   std::string str_error (int error);
-private:
-  bool extended;
 };
 
 }
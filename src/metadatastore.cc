@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "metadatastore.h"
+
+using std::string;
+using std::map;
+
+namespace Gst123
+{
+
+MetadataStore&
+MetadataStore::the()
+{
+  /* discovery threads may call this first; function local statics are initialized thread safe */
+  static MetadataStore instance;
+
+  return instance;
+}
+
+MetadataStore::MetadataStore() :
+  n_changes (0)
+{
+  g_mutex_init (&mutex);
+}
+
+void
+MetadataStore::set (const string& uri, const Entry& entry)
+{
+  g_mutex_lock (&mutex);
+  entries[uri] = entry;
+  n_changes++;
+  g_mutex_unlock (&mutex);
+}
+
+/* like set(), for entries read from a cache, so it doesn't count as a change */
+void
+MetadataStore::restore (const string& uri, const Entry& entry)
+{
+  g_mutex_lock (&mutex);
+  if (!entries.count (uri))
+    entries[uri] = entry;
+  g_mutex_unlock (&mutex);
+}
+
+bool
+MetadataStore::lookup (const string& uri, Entry& entry)
+{
+  g_mutex_lock (&mutex);
+  map<string, Entry>::const_iterator ei = entries.find (uri);
+  bool found = (ei != entries.end());
+  if (found)
+    entry = ei->second;
+  g_mutex_unlock (&mutex);
+
+  return found;
+}
+
+/* number of set() calls so far, to find out whether the store was changed */
+guint
+MetadataStore::changes()
+{
+  g_mutex_lock (&mutex);
+  guint result = n_changes;
+  g_mutex_unlock (&mutex);
+
+  return result;
+}
+
+}
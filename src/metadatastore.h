@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef GST123_METADATA_STORE_H
+#define GST123_METADATA_STORE_H
+
+#include <glib.h>
+#include <map>
+#include <string>
+
+namespace Gst123
+{
+
+struct Metadata
+{
+  double      duration;   // seconds, -1 if unknown
+  std::string title;
+  std::string artist;
+  std::string album;
+
+  Metadata() : duration (-1) {}
+};
+
+/*
+ * Durations and tags of files, indexed by uri
+ *
+ * The store is filled by the discovery threads (see Discovery), which look
+ * up files here before probing them, and can be used from any thread. Each
+ * entry has the modification time of the file it was read from, so changed
+ * files are probed again. The Library keeps the entries of files in library
+ * directories in its index, so these don't need to be probed in each run.
+ */
+class MetadataStore
+{
+public:
+  struct Entry
+  {
+    gint64   mtime;      // modification time of the file (seconds)
+    Metadata metadata;
+
+    Entry() : mtime (-1) {}
+  };
+
+private:
+  GMutex                          mutex;
+  std::map<std::string, Entry>    entries;
+  guint                           n_changes;
+
+  MetadataStore();
+
+public:
+  static MetadataStore& the();   // Singleton
+
+  void set (const std::string& uri, const Entry& entry);
+  void restore (const std::string& uri, const Entry& entry);
+  bool lookup (const std::string& uri, Entry& entry);
+  guint changes();
+};
+
+}
+
+#endif
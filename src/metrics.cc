@@ -0,0 +1,293 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <glib/gstdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "metrics.h"
+#include "utils.h"
+
+using std::string;
+using std::vector;
+
+namespace Gst123
+{
+
+static Metrics *instance = 0;
+
+Metrics&
+Metrics::the()
+{
+  if (!instance)
+    instance = new Metrics();
+
+  return *instance;
+}
+
+Metrics::Counter::Counter (const char *name, const char *help) :
+  value (0),
+  name (name),
+  help (help)
+{
+}
+
+guint64
+Metrics::Counter::get() const
+{
+  return value.load (std::memory_order_relaxed);
+}
+
+Metrics::Histogram::Histogram (const char *name, const char *help, const vector<double>& bounds) :
+  bounds (bounds),
+  buckets (bounds.size() + 1),  // last bucket: +Inf
+  count (0),
+  sum (0),
+  name (name),
+  help (help)
+{
+}
+
+void
+Metrics::Histogram::observe (double value)
+{
+  size_t b = 0;
+  while (b < bounds.size() && value > bounds[b])
+    b++;
+
+  buckets[b]++;
+  count++;
+  sum += value;
+}
+
+string
+Metrics::Histogram::format() const
+{
+  string result = string_printf ("# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+
+  /* prometheus buckets are cumulative */
+  guint64 cumulative = 0;
+  for (size_t b = 0; b < buckets.size(); b++)
+    {
+      cumulative += buckets[b];
+      string le = (b < bounds.size()) ? string_printf ("%g", bounds[b]) : "+Inf";
+      result += string_printf ("%s_bucket{le=\"%s\"} %" G_GUINT64_FORMAT "\n", name, le.c_str(), cumulative);
+    }
+  result += string_printf ("%s_sum %.6f\n", name, sum);
+  result += string_printf ("%s_count %" G_GUINT64_FORMAT "\n", name, count);
+  return result;
+}
+
+Metrics::Metrics() :
+  tracks_played ("gst123_tracks_played_total", "Number of tracks started"),
+  decode_errors ("gst123_decode_errors_total", "Number of files that could not be played"),
+  underruns ("gst123_underruns_total", "Number of times network buffering dropped below 100% during playback"),
+  dropped_frames ("gst123_dropped_frames_total", "Number of video frames dropped by the video sink"),
+  bytes_read ("gst123_bytes_read_total", "Number of bytes read from the sources"),
+  track_transition_seconds ("gst123_track_transition_seconds", "Time from starting a track until it is playing",
+                            { 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10 }),
+  seek_seconds ("gst123_seek_seconds", "Time from a seek request until the seek is complete",
+                { 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5 }),
+  service (NULL)
+{
+}
+
+static string
+format_counter (const Metrics::Counter& counter)
+{
+  return string_printf ("# HELP %s %s\n# TYPE %s counter\n%s %" G_GUINT64_FORMAT "\n",
+                        counter.name, counter.help, counter.name, counter.name, counter.get());
+}
+
+string
+Metrics::format() const
+{
+  return format_counter (tracks_played) +
+         format_counter (decode_errors) +
+         format_counter (underruns) +
+         format_counter (dropped_frames) +
+         format_counter (bytes_read) +
+         track_transition_seconds.format() +
+         seek_seconds.format();
+}
+
+bool
+Metrics::enabled() const
+{
+  return service != NULL;
+}
+
+namespace
+{
+
+/* one http request to the metrics endpoint */
+struct MetricsConnection
+{
+  GSocketConnection *connection;
+  char               buffer[1024];
+  string             request;
+  string             response;
+};
+
+void
+close_connection (MetricsConnection *mc)
+{
+  g_io_stream_close (G_IO_STREAM (mc->connection), NULL, NULL);
+  g_object_unref (mc->connection);
+  delete mc;
+}
+
+void
+write_done (GObject *source, GAsyncResult *result, gpointer data)
+{
+  MetricsConnection *mc = static_cast<MetricsConnection *> (data);
+
+  g_output_stream_write_all_finish (G_OUTPUT_STREAM (source), result, NULL, NULL);
+  close_connection (mc);
+}
+
+void
+read_done (GObject *source, GAsyncResult *result, gpointer data)
+{
+  MetricsConnection *mc = static_cast<MetricsConnection *> (data);
+
+  gssize n = g_input_stream_read_finish (G_INPUT_STREAM (source), result, NULL);
+  if (n <= 0)
+    {
+      close_connection (mc);
+      return;
+    }
+  mc->request.append (mc->buffer, n);
+
+  /* wait for the end of the request header (we answer any request with the metrics) */
+  if (mc->request.find ("\r\n\r\n") == string::npos && mc->request.find ("\n\n") == string::npos)
+    {
+      if (mc->request.size() > 16 * 1024)
+        {
+          close_connection (mc);
+          return;
+        }
+      g_input_stream_read_async (G_INPUT_STREAM (source), mc->buffer, sizeof (mc->buffer),
+                                 G_PRIORITY_DEFAULT, NULL, read_done, mc);
+      return;
+    }
+
+  string body = Metrics::the().format();
+  mc->response = string_printf ("HTTP/1.0 200 OK\r\n"
+                                "Content-Type: text/plain; version=0.0.4\r\n"
+                                "Content-Length: %zu\r\n"
+                                "Connection: close\r\n\r\n", body.size()) + body;
+
+  GOutputStream *output = g_io_stream_get_output_stream (G_IO_STREAM (mc->connection));
+  g_output_stream_write_all_async (output, mc->response.data(), mc->response.size(),
+                                   G_PRIORITY_DEFAULT, NULL, write_done, mc);
+}
+
+}
+
+gboolean
+Metrics::incoming (GSocketService *service, GSocketConnection *connection, GObject *source_object, gpointer data)
+{
+  MetricsConnection *mc = new MetricsConnection();
+  mc->connection = G_SOCKET_CONNECTION (g_object_ref (connection));
+
+  GInputStream *input = g_io_stream_get_input_stream (G_IO_STREAM (connection));
+  g_input_stream_read_async (input, mc->buffer, sizeof (mc->buffer), G_PRIORITY_DEFAULT, NULL, read_done, mc);
+  return TRUE;
+}
+
+/* address: unix:<path> or <host>:<port>, where host must be a loopback address */
+bool
+Metrics::listen (const string& address, string& error)
+{
+  GSocketAddress *socket_address = NULL;
+
+  if (g_str_has_prefix (address.c_str(), "unix:"))
+    {
+      string path = address.substr (5);
+
+      /* remove a stale socket from a previous run, but never any other file */
+      struct stat st;
+      if (lstat (path.c_str(), &st) == 0)
+        {
+          if (!S_ISSOCK (st.st_mode))
+            {
+              error = "metrics address " + address + ": address in use";
+              return false;
+            }
+          g_unlink (path.c_str());
+        }
+      socket_address = g_unix_socket_address_new (path.c_str());
+    }
+  else
+    {
+      size_t colon = address.rfind (':');
+      if (colon == string::npos)
+        {
+          error = "bad metrics address " + address + " (use unix:<path> or <host>:<port>)";
+          return false;
+        }
+      string host = address.substr (0, colon);
+      int port = atoi (address.c_str() + colon + 1);
+
+      if (host == "localhost")
+        host = "127.0.0.1";
+      if (host.size() > 2 && host[0] == '[' && host[host.size() - 1] == ']')
+        host = host.substr (1, host.size() - 2);  // [::1]
+
+      GInetAddress *inet_address = g_inet_address_new_from_string (host.c_str());
+      if (!inet_address || port <= 0 || port > 65535)
+        {
+          if (inet_address)
+            g_object_unref (inet_address);
+          error = "bad metrics address " + address + " (use unix:<path> or <host>:<port>)";
+          return false;
+        }
+      if (!g_inet_address_get_is_loopback (inet_address))
+        {
+          g_object_unref (inet_address);
+          error = "metrics address " + address + " is not a loopback address";
+          return false;
+        }
+      socket_address = g_inet_socket_address_new (inet_address, port);
+      g_object_unref (inet_address);
+    }
+
+  service = g_socket_service_new();
+
+  GError *gerror = NULL;
+  if (!g_socket_listener_add_address (G_SOCKET_LISTENER (service), socket_address, G_SOCKET_TYPE_STREAM,
+                                      G_SOCKET_PROTOCOL_DEFAULT, NULL, NULL, &gerror))
+    {
+      error = "can't listen on metrics address " + address + ": " + gerror->message;
+      g_error_free (gerror);
+      g_object_unref (socket_address);
+      g_object_unref (service);
+      service = NULL;
+      return false;
+    }
+  g_object_unref (socket_address);
+
+  g_signal_connect (service, "incoming", G_CALLBACK (incoming), NULL);
+  g_socket_service_start (service);
+  return true;
+}
+
+}
@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef GST123_METRICS_H
+#define GST123_METRICS_H
+
+#include <gio/gio.h>
+#include <string>
+#include <vector>
+#include <atomic>
+
+namespace Gst123
+{
+
+/*
+ * Playback health counters and histograms, exported in Prometheus text format
+ *
+ * Counters may be incremented from any thread (they are relaxed atomics),
+ * histograms must only be updated from the main thread, which also serves
+ * the metrics endpoint.
+ */
+class Metrics
+{
+public:
+  class Counter
+  {
+    std::atomic<guint64> value;
+  public:
+    const char *name;
+    const char *help;
+
+    Counter (const char *name, const char *help);
+
+    void
+    inc (guint64 n = 1)
+    {
+      value.fetch_add (n, std::memory_order_relaxed);
+    }
+    guint64 get() const;
+  };
+
+  class Histogram
+  {
+    std::vector<double>  bounds;
+    std::vector<guint64> buckets;   // buckets[i]: number of values <= bounds[i] (and > bounds[i - 1])
+    guint64              count;
+    double               sum;
+  public:
+    const char *name;
+    const char *help;
+
+    Histogram (const char *name, const char *help, const std::vector<double>& bounds);
+
+    void observe (double value);
+    std::string format() const;
+  };
+
+  Counter    tracks_played;
+  Counter    decode_errors;
+  Counter    underruns;
+  Counter    dropped_frames;
+  Counter    bytes_read;
+  Histogram  track_transition_seconds;
+  Histogram  seek_seconds;
+
+private:
+  GSocketService *service;
+
+  Metrics();
+
+  static gboolean incoming (GSocketService *service, GSocketConnection *connection, GObject *source_object, gpointer data);
+
+public:
+  static Metrics& the();    // Singleton
+
+  bool listen (const std::string& address, std::string& error);
+  bool enabled() const;
+  std::string format() const;
+};
+
+}
+
+#endif
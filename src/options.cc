@@ -47,9 +47,21 @@ Options::Options ()
   quiet   = FALSE;
   fullscreen = FALSE;
   uris = NULL;
+  lazy = FALSE;
+  discover = 0;
   audio_output = NULL;
   print_visualization_list = FALSE;
   visualization = NULL;
+  render = NULL;
+  jobs = 0;
+  benchmark = FALSE;
+  profile = FALSE;
+  qos_warn = 0;
+  status_fd = -1;
+  metrics = NULL;
+  track_switch_stats = FALSE;
+  startup_trace = FALSE;
+  startup_trace_json = NULL;
   skip = 0;
   initial_volume = -1; // don't touch volume setting when started
 
@@ -71,6 +83,10 @@ Options::parse (int argc, char **argv)
     {"list", '@', G_OPTION_FLAG_FILENAME, G_OPTION_ARG_CALLBACK,
       gpointer (static_cast<GOptionArgFunc> (Options::add_playlist)),
       "Read playlist of files and URIs from <filename>", "<filename>"},
+    {"lazy", '\0', 0, G_OPTION_ARG_NONE, &instance->lazy,
+      "Check files and directories only when they are played", NULL},
+    {"discover", '\0', 0, G_OPTION_ARG_INT, &instance->discover,
+      "Read durations and tags of the files in the background, using <n> threads", "<n>"},
     {"version", '\0', G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK,
       gpointer (static_cast<GOptionArgFunc> (Options::print_version)), "Print version", NULL },
     {"full-version", '\0', G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK,
@@ -101,6 +117,26 @@ Options::parse (int argc, char **argv)
       "Set subtitle file to use for video playback", "<subtitle_file>"},
     {"quiet", 'q', 0, G_OPTION_ARG_NONE, &instance->quiet,
       "Don't display any messages", NULL},
+    {"render", 'w', 0, G_OPTION_ARG_FILENAME, &instance->render,
+      "Render audio to .wav or .flac file as fast as possible (use %n or %b in <filename> for one file per track)", "<filename>"},
+    {"jobs", 'j', 0, G_OPTION_ARG_INT, &instance->jobs,
+      "Batch render mode: render <n> files in parallel (needs --render)", "<n>"},
+    {"benchmark", '\0', 0, G_OPTION_ARG_NONE, &instance->benchmark,
+      "Measure decoding speed of all files (prints JSON statistics)", NULL},
+    {"profile", '\0', 0, G_OPTION_ARG_NONE, &instance->profile,
+      "Measure processing time and latency of each pipeline element", NULL},
+    {"qos-warn", '\0', 0, G_OPTION_ARG_DOUBLE, &instance->qos_warn,
+      "Warn if more than <percent> of the video frames of a track are dropped", "<percent>"},
+    {"status-fd", '\0', 0, G_OPTION_ARG_INT, &instance->status_fd,
+      "Write machine readable status (JSON lines) to file descriptor <fd>", "<fd>"},
+    {"metrics", '\0', 0, G_OPTION_ARG_STRING, &instance->metrics,
+      "Export playback metrics (Prometheus format) on unix:<path> or <host>:<port> (loopback only)", "<address>"},
+    {"track-switch-stats", '\0', 0, G_OPTION_ARG_NONE, &instance->track_switch_stats,
+      "Print statistics on the time needed for each phase of switching tracks on exit", NULL},
+    {"startup-trace", '\0', 0, G_OPTION_ARG_NONE, &instance->startup_trace,
+      "Print a timeline of the startup phases until the first track is playing", NULL},
+    {"startup-trace-json", '\0', 0, G_OPTION_ARG_FILENAME, &instance->startup_trace_json,
+      "Write the startup timeline to <file> in Chrome trace event format", "<file>"},
     {G_OPTION_REMAINING, '\0', 0, G_OPTION_ARG_FILENAME_ARRAY, &instance->uris, "Movies to play", NULL},
     {NULL} /* end the list */
   };
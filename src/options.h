@@ -48,9 +48,21 @@ public:
   gboolean      fullscreen;
   char        **uris;
   std::list<std::string>  playlists;
+  gboolean      lazy;
+  gint          discover;
   char         *audio_output;
   char         *subtitle;
   char         *visualization;
+  char         *render;
+  gint          jobs;
+  gboolean      benchmark;
+  gboolean      profile;
+  double        qos_warn;
+  gint          status_fd;
+  char         *metrics;
+  gboolean      track_switch_stats;
+  gboolean      startup_trace;
+  char         *startup_trace_json;
 
   Options ();
   void parse (int argc, char **argv);
@@ -20,6 +20,8 @@
 
 #include "playlist.h"
 #include <iostream>
+#include <cstring>
+#include <ctype.h>
 
 using std::cerr;
 using std::endl;
@@ -32,10 +34,49 @@ PlaylistParser::~PlaylistParser()
   // virtual dtor
 }
 
+/* XSPF and JSPF locations are URIs; relative ones are percent-encoded paths */
+string
+PlaylistParser::location_from_uri_reference (const string& ref)
+{
+  char *scheme = g_uri_parse_scheme (ref.c_str());
+  if (scheme)
+    {
+      g_free (scheme);
+      return ref;
+    }
+
+  char *unescaped = g_uri_unescape_string (ref.c_str(), NULL);
+  string location = unescaped ? unescaped : ref;
+  g_free (unescaped);
+
+  return location;
+}
+
+PlaylistEntryHandler::~PlaylistEntryHandler()
+{
+  // virtual dtor
+}
+
+/* parse the whole playlist, the entries are stored in the Playlist itself */
 Playlist::Playlist (const string& uri_str)
 {
-  string errorstr;
+  load (uri_str, *this);
+
+  if (error)
+    cerr << "Playlist Error: " << error_str << endl;
+}
 
+/* parse the playlist, passing each entry to the handler as soon as it is
+ * available; errors are not printed (use error_message())
+ */
+Playlist::Playlist (const string& uri_str, PlaylistEntryHandler& handler)
+{
+  load (uri_str, handler);
+}
+
+void
+Playlist::load (const string& uri_str, PlaylistEntryHandler& handler)
+{
   register_parsers();
   URI uri (uri_str);
 
@@ -43,33 +84,84 @@ Playlist::Playlist (const string& uri_str)
 
   if (error)
     {
-      cerr << "Playlist Error: " << uri.strerror(error) << endl;
+      error_str = uri.strerror (error);
       return;
     }
 
-  error = parse (uri);
+  error = parse (uri, handler);
 
   if (error == PLAYLIST_PARSER_NOTIMPL)
-    cerr << "Playlist Error: Parser not implemented for this playlist type" << endl;
+    error_str = "Parser not implemented for this playlist type";
+  else if (error == PLAYLIST_PARSER_NOT_PLAYLIST)
+    error_str = "Not a playlist (binary data)";
   else if (error)
     {
-      string err = current_parser->str_error (error);
-
-      if (err == "")
-        err = uri.read_strerror (error);
+      error_str = current_parser->str_error (error);
 
-      cerr << "Playlist Error: " << err << endl;
+      if (error_str == "")
+        error_str = uri.read_strerror (error);
     }
 }
 
+void
+Playlist::add_entry (const PlaylistEntry& entry)
+{
+  push_back (entry);
+}
+
+string
+Playlist::error_message()
+{
+  return error_str;
+}
+
+/* checks whether a playlist entry refers to another playlist (by extension)
+ *
+ * .m3u8 is not included: it is used for HLS streams, which GStreamer plays itself
+ */
+bool
+Playlist::is_playlist_location (const string& location)
+{
+  string path = location;
+  if (path.find ("://") != string::npos)
+    path = path.substr (0, path.find_first_of ("?#"));
+
+  char *lower = g_ascii_strdown (path.c_str(), -1);
+  string lpath = lower;
+  g_free (lower);
+
+  return g_str_has_suffix (lpath.c_str(), ".m3u") || g_str_has_suffix (lpath.c_str(), ".pls") ||
+         g_str_has_suffix (lpath.c_str(), ".xspf") || g_str_has_suffix (lpath.c_str(), ".jspf") ||
+         g_str_has_suffix (lpath.c_str(), ".cue");
+}
+
+/* entry locations are relative to the directory containing the playlist */
+string
+Playlist::resolve_location (const string& playlist, const string& location)
+{
+  if ((location.find (":") != string::npos) || g_path_is_absolute (location.c_str()))
+    return location;
+
+  char *playlist_dirname = g_path_get_dirname (playlist.c_str());
+  char *filename = g_build_filename (playlist_dirname, location.c_str(), NULL);
+  string result = filename;
+  g_free (filename);
+  g_free (playlist_dirname);
+
+  return result;
+}
+
 void
 Playlist::register_parsers()
 {
   current_parser = NULL;
   parser_register.push_back (new PLSParser());
+  parser_register.push_back (new XSPFParser());
+  parser_register.push_back (new JSPFParser());
+  parser_register.push_back (new CUEParser());
 
-  // Make sure that this is last. It acts as a catch-all since the format
-  // is simply one entry per line.
+  // Make sure that this is last. It acts as a catch-all for text files
+  // since the format is simply one entry per line.
   parser_register.push_back (new M3UParser());
 }
 
@@ -82,19 +174,98 @@ Playlist::is_valid()
     return true;
 }
 
+/* maximum number of bytes we look at to determine the playlist format */
+static const size_t SNIFF_LEN = 512;
+
+/* binary files (i.e. media files passed as playlist) contain control characters */
+static bool
+looks_like_text (const string& data)
+{
+  size_t control_chars = 0;
+
+  for (size_t i = 0; i < data.size(); i++)
+    {
+      unsigned char c = data[i];
+      if (c == 0)
+        return false;
+      if (c < 32 && c != '\t' && c != '\n' && c != '\r' && c != '\f')
+        control_chars++;
+    }
+  return control_chars * 20 <= data.size();  // allow a few (5%)
+}
+
+/* find the parser for the stream: by content type, or by matching the
+ * beginning of the content against the magic strings of all formats
+ */
 int
-Playlist::parse (URI &uri)
+Playlist::sniff (IOStream *stream, PlaylistParser *& parser)
 {
-  IOStream *stream = uri.get_io_stream ();
+  string content_type = stream->get_content_type();
+  content_type = content_type.substr (0, content_type.find (';'));  // strip "; charset=..."
+  while (!content_type.empty() && isspace (content_type[content_type.size() - 1]))
+    content_type.erase (content_type.size() - 1);
+
+  if (content_type != "")
+    {
+      for (size_t i = 0; i < parser_register.size(); i++)
+        {
+          const PlaylistFormat& format = parser_register[i]->format();
+          for (const char * const *ct = format.content_types; *ct; ct++)
+            {
+              if (g_ascii_strcasecmp (content_type.c_str(), *ct) == 0)
+                {
+                  parser = parser_register[i];
+                  return 0;
+                }
+            }
+        }
+      // servers often send generic content types (text/plain), so we still look at the content
+    }
+
+  string data = stream->peek_line (SNIFF_LEN);
+  if (!looks_like_text (data))
+    return PLAYLIST_PARSER_NOT_PLAYLIST;
+
+  size_t start = 0;
+  if (data.compare (0, 3, "\xef\xbb\xbf") == 0)  // UTF-8 BOM
+    start = 3;
+  while (start < data.size() && isspace (data[start]))
+    start++;
+  data.erase (0, start);
 
+  PlaylistParser *fallback = NULL;
   for (size_t i = 0; i < parser_register.size(); i++)
     {
-      if (parser_register[i]->identify (stream))
+      const PlaylistFormat& format = parser_register[i]->format();
+      for (const char * const *magic = format.magics; *magic; magic++)
         {
-          current_parser = parser_register[i];
-          return parser_register[i]->parse (*this, stream);
+          if (data.compare (0, strlen (*magic), *magic) == 0)
+            {
+              parser = parser_register[i];
+              return 0;
+            }
         }
+      if (format.text_fallback && !fallback)
+        fallback = parser_register[i];
     }
 
-  return PLAYLIST_PARSER_NOTIMPL;
+  if (!fallback)
+    return PLAYLIST_PARSER_NOTIMPL;
+
+  parser = fallback;
+  return 0;
+}
+
+int
+Playlist::parse (URI &uri, PlaylistEntryHandler& handler)
+{
+  IOStream *stream = uri.get_io_stream ();
+  PlaylistParser *parser = NULL;
+
+  int ret = sniff (stream, parser);
+  if (ret != 0)
+    return ret;
+
+  current_parser = parser;
+  return parser->parse (handler, stream);
 }
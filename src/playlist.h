@@ -33,32 +33,88 @@ namespace Gst123 {
 
 enum
 {
-  PLAYLIST_PARSER_NOTIMPL = -1
+  PLAYLIST_PARSER_NOTIMPL = -1,
+  PLAYLIST_PARSER_NOT_PLAYLIST = -2
+};
+
+/*
+ * One playlist entry; duration and title are only known if the playlist
+ * format provides them (#EXTINF in extended M3U, LengthN/TitleN in PLS);
+ * cue sheets produce virtual tracks, which are a part of a file
+ */
+struct PlaylistEntry
+{
+  std::string location;
+  double      duration;   // in seconds, -1 if unknown
+  std::string title;      // empty if unknown
+  double      start;      // virtual tracks (cue sheets): start in seconds, -1 for normal entries
+  double      end;        // virtual tracks (cue sheets): end in seconds, -1 if playing until the end of the file
+
+  PlaylistEntry (const std::string& location = "") :
+    location (location),
+    duration (-1),
+    start (-1),
+    end (-1)
+  {
+  }
+};
+
+/*
+ * Receives the entries of a playlist, as soon as they are parsed
+ */
+struct PlaylistEntryHandler
+{
+  virtual void add_entry (const PlaylistEntry& entry) = 0;
+
+  virtual ~PlaylistEntryHandler();
+};
+
+/*
+ * How a playlist format is recognized: by content type (http), or by the
+ * beginning of the content (ignoring a BOM and leading whitespace); all lists
+ * are NULL terminated
+ */
+struct PlaylistFormat
+{
+  const char * const *content_types;
+  const char * const *magics;
+  bool                text_fallback;   // used for text content no other format recognizes
 };
 
 struct PlaylistParser
 {
-  virtual int parse (std::vector<std::string>& output, IOStream *stream) = 0;
-  virtual bool identify (IOStream *stream) = 0;
+  virtual int parse (PlaylistEntryHandler& output, IOStream *stream) = 0;
+  virtual const PlaylistFormat& format() = 0;
   virtual std::string str_error (int error = 0) = 0;
 
   virtual ~PlaylistParser();
 
+  static std::string location_from_uri_reference (const std::string& ref);
+
 protected:
   int status;
 };
 
-class Playlist : public std::vector<std::string>
+class Playlist : public std::vector<PlaylistEntry>, private PlaylistEntryHandler
 {
   std::vector<PlaylistParser *> parser_register;
   PlaylistParser *current_parser;
 
-  int parse (URI &uri);
+  int parse (URI &uri, PlaylistEntryHandler& handler);
+  int sniff (IOStream *stream, PlaylistParser *& parser);
+  void load (const std::string& uri_str, PlaylistEntryHandler& handler);
   void register_parsers (void);
+  void add_entry (const PlaylistEntry& entry);
   int error;
+  std::string error_str;
 public:
   Playlist (const std::string& uri_str);
+  Playlist (const std::string& uri_str, PlaylistEntryHandler& handler);
   bool is_valid();
+  std::string error_message();
+
+  static bool is_playlist_location (const std::string& location);
+  static std::string resolve_location (const std::string& playlist, const std::string& location);
 
   ~Playlist (void)
   {
@@ -71,6 +127,9 @@ public:
 
 // The list of parsers
 #include "plsparser.h"
+#include "xspfparser.h"
+#include "jspfparser.h"
+#include "cueparser.h"
 #include "m3uparser.h"
 
 #endif
@@ -0,0 +1,531 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "playlistloader.h"
+#include "uriresolver.h"
+
+#include <stdlib.h>
+
+using std::string;
+using std::list;
+using std::set;
+using std::vector;
+
+namespace Gst123
+{
+
+/* number of nested playlists fetched at the same time */
+static const int MAX_FETCH_THREADS = 4;
+
+/* playlists nested deeper than this are skipped */
+static const int MAX_NESTING_DEPTH = 8;
+
+/* maximum number of entries resolved by one pool thread at once; entries
+ * are only collected into batches while the resolve pool is busy, so that
+ * entries from a slow playlist (network, stdin) are passed on right away
+ */
+static const size_t RESOLVE_BATCH_SIZE = 1024;
+
+/* one idle callback delivers at most this many items (or for at most
+ * DELIVER_CHUNK_TIME), so that key presses and bus messages are not delayed
+ * by a long playlist
+ */
+static const int    DELIVER_CHUNK_SIZE = 256;
+static const gint64 DELIVER_CHUNK_TIME = 5 * G_TIME_SPAN_MILLISECOND;
+
+static string
+playlist_dir (const string& playlist)
+{
+  char *dirname = g_path_get_dirname (playlist.c_str());
+  string result = dirname;
+  g_free (dirname);
+
+  return result;
+}
+
+/* same rule as Playlist::resolve_location(), but with a precomputed directory */
+static string
+relative_to_dir (const string& base_dir, const string& location)
+{
+  if (location.find (':') == string::npos && !g_path_is_absolute (location.c_str()))
+    return UriResolver::join_path (base_dir, location);
+
+  return location;
+}
+
+/* the same playlist can be written as relative or absolute path, file uri or
+ * via symlinks, so cycles are detected using the real path of local files
+ */
+static string
+canonical_location (const string& location)
+{
+  string path = location;
+  if (UriResolver::has_scheme (location))
+    {
+      char *filename = g_filename_from_uri (location.c_str(), NULL, NULL);
+      if (!filename)
+        return location;   // not a local file
+
+      path = filename;
+      g_free (filename);
+    }
+
+  char *real_path = realpath (path.c_str(), NULL);
+  if (!real_path)
+    return UriResolver::file_uri (UriResolver::absolute_path (path));
+
+  string result = UriResolver::file_uri (real_path);
+  free (real_path);
+  return result;
+}
+
+PlaylistLoader::Handler::~Handler()
+{
+  // virtual dtor
+}
+
+PlaylistLoader::State::State() :
+  ref_count (1),
+  idle_pending (false),
+  cancelled (false),
+  handler (NULL),
+  pool (NULL),
+  resolve_pool (NULL),
+  resolve_entries (true),
+  resolving (0)
+{
+  g_mutex_init (&mutex);
+  g_cond_init (&slots_cond);
+}
+
+PlaylistLoader::State::~State()
+{
+  g_cond_clear (&slots_cond);
+  g_mutex_clear (&mutex);
+}
+
+void
+PlaylistLoader::State::unref()
+{
+  if (g_atomic_int_dec_and_test (&ref_count))
+    delete this;
+}
+
+bool
+PlaylistLoader::State::is_cancelled()
+{
+  g_mutex_lock (&mutex);
+  bool result = cancelled;
+  g_mutex_unlock (&mutex);
+
+  return result;
+}
+
+/* called by the playlist parser, in the loader thread */
+void
+PlaylistLoader::State::add_entry (const PlaylistEntry& entry)
+{
+  if (Playlist::is_playlist_location (entry.location))
+    {
+      flush_batch();
+
+      Slot slot;
+      slot.ready = false;
+      slot.location = Playlist::resolve_location (current_playlist, entry.location);
+      slot.parent = current_playlist;
+      slot.ancestors.insert (canonical_location (current_playlist));
+
+      g_mutex_lock (&mutex);
+      slots.push_back (slot);
+      Slot *slot_ptr = &slots.back();
+      g_mutex_unlock (&mutex);
+
+      g_thread_pool_push (pool, slot_ptr, NULL);
+      return;
+    }
+
+  Item item;
+  item.type = Item::ENTRY;
+  item.playlist = current_playlist;
+  item.entry = entry;
+
+  if (!resolve_entries)
+    {
+      /* the handler checks the entry once it needs it */
+      item.entry.location = relative_to_dir (current_dir, entry.location);
+      add_item (item);
+      return;
+    }
+
+  g_mutex_lock (&mutex);
+  if (batch.empty())
+    batch_dir = current_dir;
+  batch.push_back (item);
+
+  if (batch.size() >= RESOLVE_BATCH_SIZE || resolving == 0)
+    flush_batch_locked();
+  g_mutex_unlock (&mutex);
+}
+
+void
+PlaylistLoader::State::flush_batch()
+{
+  g_mutex_lock (&mutex);
+  flush_batch_locked();
+  g_mutex_unlock (&mutex);
+}
+
+/* passes the unresolved entries to the resolve pool */
+void
+PlaylistLoader::State::flush_batch_locked()
+{
+  if (batch.empty())
+    return;
+
+  slots.push_back (Slot());
+  Slot *slot_ptr = &slots.back();
+  slot_ptr->ready = false;
+  slot_ptr->items.swap (batch);
+  slot_ptr->base_dir = batch_dir;
+  resolving++;
+
+  g_thread_pool_push (resolve_pool, slot_ptr, NULL);
+}
+
+void
+PlaylistLoader::State::add_item (const Item& item)
+{
+  g_mutex_lock (&mutex);
+  if (slots.empty())
+    {
+      items.push_back (item);
+    }
+  else
+    {
+      /* wait for the nested playlists before this item */
+      Slot slot;
+      slot.ready = true;
+      slot.items.push_back (item);
+      slots.push_back (slot);
+    }
+  flush_locked();
+  g_mutex_unlock (&mutex);
+}
+
+/* moves items of ready slots (in order) to the delivery queue */
+void
+PlaylistLoader::State::flush_locked()
+{
+  while (!slots.empty() && slots.front().ready)
+    {
+      items.insert (items.end(), slots.front().items.begin(), slots.front().items.end());
+      slots.pop_front();
+    }
+  if (slots.empty())
+    g_cond_broadcast (&slots_cond);
+
+  if (cancelled)
+    {
+      items.clear();
+      return;
+    }
+
+  /* the idle callback runs until all queued items are delivered */
+  if (!items.empty() && !idle_pending)
+    {
+      idle_pending = true;
+      g_atomic_int_inc (&ref_count);
+      g_idle_add (idle_deliver, this);
+    }
+}
+
+/* converts the entry location to an URI (or an absolute directory name);
+ * relative locations are relative to base_dir, the directory of the playlist
+ */
+void
+PlaylistLoader::resolve (Item& item, const string& base_dir)
+{
+  string& location = item.entry.location;
+
+  location = relative_to_dir (base_dir, location);
+
+  item.is_directory = false;
+  if (!UriResolver::has_scheme (location))
+    {
+      string path = UriResolver::absolute_path (location);
+      if (UriResolver::file_info (path) == FI_DIR)
+        {
+          location = path;
+          item.is_directory = true;
+        }
+      else
+        {
+          location = UriResolver::file_uri (path);
+        }
+    }
+}
+
+/* fetches a nested playlist and (recursively) its nested playlists */
+void
+PlaylistLoader::expand (State *state, const string& location, const string& parent, int depth,
+                        set<string> ancestors, vector<Item>& out)
+{
+  Item warning;
+  warning.type = Item::WARNING;
+  warning.playlist = parent;
+
+  if (depth > MAX_NESTING_DEPTH)
+    {
+      warning.message = "playlist " + location + " is nested too deeply, skipped";
+      out.push_back (warning);
+      return;
+    }
+  string key = canonical_location (location);
+  if (ancestors.count (key))
+    {
+      warning.message = "playlist " + location + " includes itself, skipped";
+      out.push_back (warning);
+      return;
+    }
+  ancestors.insert (key);
+
+  struct Collector : public PlaylistEntryHandler
+  {
+    vector<PlaylistEntry> entries;
+
+    void
+    add_entry (const PlaylistEntry& entry)
+    {
+      entries.push_back (entry);
+    }
+  } collector;
+
+  Playlist playlist (location, collector);
+  if (!playlist.is_valid())
+    {
+      warning.message = "could not load playlist " + location + ": " + playlist.error_message();
+      out.push_back (warning);
+    }
+
+  string base_dir = playlist_dir (location);
+  for (vector<PlaylistEntry>::const_iterator ei = collector.entries.begin(); ei != collector.entries.end(); ei++)
+    {
+      if (state->is_cancelled())
+        return;
+
+      if (Playlist::is_playlist_location (ei->location))
+        {
+          expand (state, Playlist::resolve_location (location, ei->location), location, depth + 1, ancestors, out);
+        }
+      else
+        {
+          Item item;
+          item.type = Item::ENTRY;
+          item.playlist = location;
+          item.entry = *ei;
+          if (state->resolve_entries)
+            resolve (item, base_dir);
+          else
+            item.entry.location = relative_to_dir (base_dir, ei->location);
+          out.push_back (item);
+        }
+    }
+}
+
+void
+PlaylistLoader::expand_func (gpointer data, gpointer user_data)
+{
+  Slot  *slot = static_cast<Slot *> (data);
+  State *state = static_cast<State *> (user_data);
+
+  vector<Item> items;
+  if (!state->is_cancelled())
+    expand (state, slot->location, slot->parent, 1, slot->ancestors, items);
+
+  g_mutex_lock (&state->mutex);
+  slot->items.swap (items);
+  slot->ready = true;
+  state->flush_locked();
+  g_mutex_unlock (&state->mutex);
+}
+
+void
+PlaylistLoader::resolve_func (gpointer data, gpointer user_data)
+{
+  Slot  *slot = static_cast<Slot *> (data);
+  State *state = static_cast<State *> (user_data);
+
+  if (!state->is_cancelled())
+    {
+      for (vector<Item>::iterator ii = slot->items.begin(); ii != slot->items.end(); ii++)
+        resolve (*ii, slot->base_dir);
+    }
+
+  g_mutex_lock (&state->mutex);
+  slot->ready = true;
+  state->resolving--;
+
+  /* the pool is idle now: don't keep the entries the loader collected meanwhile
+   * until it parses more (which may take a while for network playlists)
+   */
+  if (state->resolving == 0 && !state->cancelled)
+    state->flush_batch_locked();
+  state->flush_locked();
+  g_mutex_unlock (&state->mutex);
+}
+
+gpointer
+PlaylistLoader::thread_func (gpointer data)
+{
+  State *state = static_cast<State *> (data);
+
+  state->pool = g_thread_pool_new (expand_func, state, MAX_FETCH_THREADS, FALSE, NULL);
+  state->resolve_pool = g_thread_pool_new (resolve_func, state, g_get_num_processors(), FALSE, NULL);
+
+  for (list<string>::const_iterator pi = state->playlists.begin(); pi != state->playlists.end(); pi++)
+    {
+      state->current_playlist = *pi;
+      state->current_dir = playlist_dir (*pi);
+
+      Playlist playlist (*pi, *state);
+      state->flush_batch();
+      if (!playlist.is_valid())
+        {
+          Item item;
+          item.type = Item::ERROR;
+          item.playlist = *pi;
+          item.message = playlist.error_message();
+          state->add_item (item);
+        }
+
+      if (state->is_cancelled())
+        break;
+    }
+
+  /* wait for nested playlists and entries which are being resolved */
+  g_mutex_lock (&state->mutex);
+  while (!state->slots.empty() && !state->cancelled)
+    g_cond_wait (&state->slots_cond, &state->mutex);
+  g_mutex_unlock (&state->mutex);
+
+  /* after cancel, nested playlists which are not being fetched yet are dropped */
+  g_thread_pool_free (state->pool, TRUE, TRUE);
+  g_thread_pool_free (state->resolve_pool, TRUE, TRUE);
+  state->pool = NULL;
+  state->resolve_pool = NULL;
+
+  Item item;
+  item.type = Item::DONE;
+  state->add_item (item);
+
+  state->unref();
+  return NULL;
+}
+
+gboolean
+PlaylistLoader::idle_deliver (gpointer data)
+{
+  State *state = static_cast<State *> (data);
+  gint64 end_time = g_get_monotonic_time() + DELIVER_CHUNK_TIME;
+
+  for (int n = 0; n < DELIVER_CHUNK_SIZE && g_get_monotonic_time() < end_time; n++)
+    {
+      g_mutex_lock (&state->mutex);
+      if (state->items.empty() || state->cancelled)
+        {
+          state->idle_pending = false;
+          g_mutex_unlock (&state->mutex);
+
+          state->unref();
+          return FALSE;
+        }
+      Item item = state->items.front();
+      state->items.pop_front();
+      g_mutex_unlock (&state->mutex);
+
+      /* the handler may cancel loading, for instance if it quits */
+      if (item.type == Item::ENTRY)
+        state->handler->playlist_entry (item.entry, item.is_directory);
+      else if (item.type == Item::ERROR)
+        state->handler->playlist_error (item.playlist, item.message);
+      else if (item.type == Item::WARNING)
+        state->handler->playlist_warning (item.playlist, item.message);
+      else
+        state->handler->playlist_done();
+    }
+
+  g_mutex_lock (&state->mutex);
+  bool more = !state->items.empty() && !state->cancelled;
+  if (!more)
+    state->idle_pending = false;
+  g_mutex_unlock (&state->mutex);
+
+  if (more)
+    return TRUE;
+
+  state->unref();
+  return FALSE;
+}
+
+PlaylistLoader::PlaylistLoader() :
+  state (NULL)
+{
+}
+
+PlaylistLoader::~PlaylistLoader()
+{
+  /* the thread may block in a slow network read, so we don't wait for it;
+   * it will free the shared state once it's done
+   */
+  cancel();
+}
+
+void
+PlaylistLoader::start (const list<string>& playlists, Handler *handler, bool resolve_entries)
+{
+  g_return_if_fail (state == NULL);
+
+  state = new State();
+  state->playlists = playlists;
+  state->handler = handler;
+  state->resolve_entries = resolve_entries;
+
+  g_atomic_int_inc (&state->ref_count);
+  GThread *thread = g_thread_new ("playlist-loader", thread_func, state);
+  g_thread_unref (thread);
+}
+
+void
+PlaylistLoader::cancel()
+{
+  if (!state)
+    return;
+
+  g_mutex_lock (&state->mutex);
+  state->cancelled = true;
+  state->items.clear();
+  g_cond_broadcast (&state->slots_cond);
+  g_mutex_unlock (&state->mutex);
+
+  state->unref();
+  state = NULL;
+}
+
+}
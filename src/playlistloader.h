@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef GST123_PLAYLIST_LOADER_H
+#define GST123_PLAYLIST_LOADER_H
+
+#include "playlist.h"
+#include <glib.h>
+#include <deque>
+#include <list>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace Gst123
+{
+
+/*
+ * Parses playlists in a background thread
+ *
+ * Entries are passed to the handler (in the main thread) while parsing
+ * continues, so the player can start playing after the first entry even for
+ * huge or slow remote playlists. Playlists are parsed one after another, so
+ * entries are delivered in playlist order.
+ *
+ * Entries which are playlists themselves (.m3u/.pls, i.e. radio directories)
+ * are expanded: they are fetched concurrently by a small thread pool, but
+ * their entries are still delivered at the position of the nested playlist.
+ *
+ * Entry locations are resolved (to URIs or absolute directory names) in
+ * batches by another thread pool, so for huge local playlists the stat()
+ * calls don't slow down parsing or the main thread.
+ */
+class PlaylistLoader
+{
+public:
+  struct Handler
+  {
+    /* entry.location is an URI, or an absolute path if is_directory is true;
+     * without resolve_entries, it's the unchecked location (made relative to
+     * the current directory instead of the playlist)
+     */
+    virtual void playlist_entry (const PlaylistEntry& entry, bool is_directory) = 0;
+    virtual void playlist_error (const std::string& playlist, const std::string& error) = 0;
+    virtual void playlist_warning (const std::string& playlist, const std::string& warning) = 0;
+    virtual void playlist_done() = 0;
+
+    virtual ~Handler();
+  };
+
+private:
+  struct Item
+  {
+    enum Type { ENTRY, ERROR, WARNING, DONE } type;
+    std::string   playlist;       // the playlist containing the entry
+    PlaylistEntry entry;
+    bool          is_directory;   // set once the entry is resolved
+    std::string   message;
+
+    Item() : type (ENTRY), is_directory (false) {}
+  };
+
+  /* items are delivered in slot order; a slot for a nested playlist or a
+   * batch of entries becomes ready once a pool thread has expanded/resolved it
+   */
+  struct Slot
+  {
+    bool                  ready;
+    std::vector<Item>     items;
+    std::string           location;    // nested playlist to expand
+    std::string           parent;
+    std::set<std::string> ancestors;   // for cycle detection (canonical locations)
+    std::string           base_dir;    // for resolving a batch of entries
+  };
+
+  /* shared between main thread and loader threads; freed by whoever drops the last reference */
+  struct State : public PlaylistEntryHandler
+  {
+    gint                    ref_count;
+    GMutex                  mutex;
+    GCond                   slots_cond;
+    std::list<Slot>         slots;          // protected by mutex
+    std::deque<Item>        items;          // protected by mutex
+    bool                    idle_pending;   // protected by mutex
+    bool                    cancelled;      // protected by mutex
+    Handler                *handler;        // only used in main thread
+    GThreadPool            *pool;
+    GThreadPool            *resolve_pool;
+    bool                    resolve_entries;
+    std::list<std::string>  playlists;
+    std::string             current_playlist;
+    std::string             current_dir;
+    std::vector<Item>       batch;          // entries which are not resolved yet, protected by mutex
+    std::string             batch_dir;      // directory of the playlist of the batch, protected by mutex
+    int                     resolving;      // batches in the resolve pool, protected by mutex
+
+    State();
+    ~State();
+
+    void add_entry (const PlaylistEntry& entry);
+    void add_item (const Item& item);
+    void flush_batch();
+    void flush_batch_locked();
+    void flush_locked();
+    bool is_cancelled();
+    void unref();
+  };
+
+  State *state;
+
+  static void expand (State *state, const std::string& location, const std::string& parent, int depth,
+                      std::set<std::string> ancestors, std::vector<Item>& out);
+  static void resolve (Item& item, const std::string& base_dir);
+  static gpointer thread_func (gpointer data);
+  static void expand_func (gpointer data, gpointer user_data);
+  static void resolve_func (gpointer data, gpointer user_data);
+  static gboolean idle_deliver (gpointer data);
+
+public:
+  PlaylistLoader();
+  ~PlaylistLoader();
+
+  void start (const std::list<std::string>& playlists, Handler *handler, bool resolve_entries = true);
+  void cancel();
+};
+
+}
+
+#endif
@@ -22,38 +22,60 @@
 #include <ctype.h>
 #include <cstring>
 #include <errno.h>
+#include <stdlib.h>
+#include <glib.h>
+#include <map>
 
 using std::string;
 using std::vector;
+using std::map;
 
 using namespace Gst123;
 
-const string PLSParser::type = "audio/x-scpls";
+static const char * const pls_content_types[] = { "audio/x-scpls", NULL };
+static const char * const pls_magics[] = { "[playlist]", "[Playlist]", NULL };
 
-bool
-PLSParser::identify (IOStream *stream)
+const PlaylistFormat&
+PLSParser::format()
 {
-  // Trust the content type first
-  if (stream->get_content_type() == PLSParser::type)
-    return true;
-  else if (stream->get_content_type() != "")
+  static const PlaylistFormat pls_format = { pls_content_types, pls_magics, false };
+  return pls_format;
+}
+
+/* splits "<key><number>=<value>", for instance "File3=foo.ogg" */
+static bool
+split_entry_line (const string& line, const string& key, int& number, string& value)
+{
+  if (line.compare (0, key.size(), key) != 0)
     return false;
 
-  if (stream->content_begins_with ("[playlist]"))
-    return true;
-  else
+  size_t eq_pos = line.find ('=');
+  if (eq_pos == string::npos)
     return false;
+
+  number = atoi (line.substr (key.size(), eq_pos - key.size()).c_str());
+  value = line.substr (eq_pos + 1);
+  while (!value.empty() && isspace (value[0]))
+    value.erase (0, 1);
+  while (!value.empty() && isspace (value[value.size() - 1]))
+    value.erase (value.size() - 1);
+  return true;
 }
 
 // Parse the playlist
-// Currently we are only picking out the file to be played
-// and we don't really care about the playlist entry information
-// such as the title, artist, etc.
+// Besides the file to be played, we pick out the title and duration
+// of each entry (if available)
 int
-PLSParser::parse (vector<string>& list, IOStream *stream)
+PLSParser::parse (PlaylistEntryHandler& output, IOStream *stream)
 {
   int ret = 0;
 
+  /* TitleN and LengthN may occur before or after FileN, so we collect
+   * everything first and keep the order of the FileN lines
+   */
+  map<int, PlaylistEntry> entries;
+  vector<int> order;
+
   do
     {
       string curline = stream->get_current_line();
@@ -64,18 +86,30 @@ PLSParser::parse (vector<string>& list, IOStream *stream)
       while (!curline.empty() && isspace (curline[0]))
         curline.erase (0, 1);
 
-      if (curline.substr (0, 4) == "File")
+      int number;
+      string value;
+      if (split_entry_line (curline, "File", number, value))
 	{
-	  int pos = curline.find ("=");
-	  string ret = curline.substr (pos+1, string::npos);
-	  while (!ret.empty() && isspace (ret[0]))
-	    ret.erase (0, 1);
-
-	  list.push_back (ret);
+	  if (entries[number].location == "")
+	    order.push_back (number);
+	  entries[number].location = value;
 	}
+      else if (split_entry_line (curline, "Title", number, value))
+        {
+          entries[number].title = value;
+        }
+      else if (split_entry_line (curline, "Length", number, value))
+        {
+          double duration = g_ascii_strtod (value.c_str(), NULL);
+          if (duration > 0)   // -1 is used for "unknown" (i.e. streams)
+            entries[number].duration = duration;
+        }
     }
   while ((ret = stream->readline()) >= 0);
 
+  for (vector<int>::const_iterator oi = order.begin(); oi != order.end(); oi++)
+    output.add_entry (entries[*oi]);
+
   if (ret == IO_STREAM_EOF)  // EOF is not an error
     ret = 0;
 
@@ -32,11 +32,9 @@ namespace Gst123
 
 struct PLSParser : PlaylistParser
 {
-  int parse (std::vector<std::string>& list, IOStream *stream);
-  bool identify (IOStream *stream);
+  int parse (PlaylistEntryHandler& output, IOStream *stream);
+  const PlaylistFormat& format();
   std::string str_error (int error);
-private:
-  static const std::string type;
 };
 
 }
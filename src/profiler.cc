@@ -0,0 +1,344 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "profiler.h"
+#include "msg.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <deque>
+
+using std::string;
+using std::vector;
+using std::map;
+using std::deque;
+using std::pair;
+using std::make_pair;
+
+namespace Gst123
+{
+
+namespace
+{
+
+struct ElementProbe
+{
+  ElementProfiler        *profiler;
+  ElementProfiler::Stats *stats;
+  GMutex                  mutex;
+  deque< pair<GstClockTime, GstClockTime> > in_flight; // (pts, entry time), protected by mutex
+  vector< pair<GThread *, GstClockTime> > entry_times; // time a buffer entered the element, per streaming thread, protected by mutex
+};
+
+/* bounds memory usage for elements which drop buffers */
+const size_t MAX_IN_FLIGHT = 1024;
+
+void
+free_element_probe (gpointer data)
+{
+  ElementProbe *probe = static_cast<ElementProbe *> (data);
+
+  g_mutex_clear (&probe->mutex);
+  delete probe;
+}
+
+bool
+cmp_proc_time (const ElementProfiler::Stats& a, const ElementProfiler::Stats& b)
+{
+  return a.proc_ns > b.proc_ns;
+}
+
+}
+
+ElementProfiler::Stats::Stats() :
+  instances (0),
+  buffers (0),
+  proc_count (0),
+  proc_ns (0),
+  max_proc_ns (0),
+  latency_count (0),
+  latency_ns (0),
+  max_latency_ns (0)
+{
+}
+
+ElementProfiler::ElementProfiler() :
+  start_time (0),
+  attached (false)
+{
+  g_mutex_init (&mutex);
+}
+
+ElementProfiler::~ElementProfiler()
+{
+  for (map<string, Stats *>::iterator si = stats.begin(); si != stats.end(); si++)
+    delete si->second;
+
+  g_mutex_clear (&mutex);
+}
+
+void
+ElementProfiler::attach (GstElement *pipeline)
+{
+  if (attached)
+    return;
+
+  attached = true;
+  start_time = get_time();
+
+  /* elements which already exist ... */
+  GstIterator *iterator = gst_bin_iterate_recurse (GST_BIN (pipeline));
+  gst_iterator_foreach (iterator, attach_iterfunc, this);
+  gst_iterator_free (iterator);
+
+  /* ... and elements which will be created later on (for instance the decoders for each track) */
+  g_signal_connect (pipeline, "deep-element-added", G_CALLBACK (deep_element_added), this);
+}
+
+void
+ElementProfiler::attach_iterfunc (const GValue *evalue, gpointer data)
+{
+  ElementProfiler *self = static_cast<ElementProfiler *> (data);
+
+  self->attach_element (GST_ELEMENT (g_value_get_object (evalue)));
+}
+
+void
+ElementProfiler::deep_element_added (GstBin *bin, GstBin *sub_bin, GstElement *element, gpointer data)
+{
+  // this callback doesn't necessarily occur in main thread
+  ElementProfiler *self = static_cast<ElementProfiler *> (data);
+
+  self->attach_element (element);
+}
+
+void
+ElementProfiler::attach_element (GstElement *element)
+{
+  /* for bins, the elements inside the bin are measured */
+  if (GST_IS_BIN (element) || g_object_get_data (G_OBJECT (element), "gst123-profiler"))
+    return;
+
+  string name;
+  GstElementFactory *factory = gst_element_get_factory (element);
+  if (factory)
+    name = gst_plugin_feature_get_name (GST_PLUGIN_FEATURE (factory));
+  else
+    name = G_OBJECT_TYPE_NAME (element);
+
+  ElementProbe *probe = new ElementProbe();
+  probe->profiler = this;
+  g_mutex_init (&probe->mutex);
+
+  g_mutex_lock (&mutex);
+  Stats*& element_stats = stats[name];
+  if (!element_stats)
+    {
+      element_stats = new Stats();
+      element_stats->name = name;
+    }
+  element_stats->instances++;
+  probe->stats = element_stats;
+  g_mutex_unlock (&mutex);
+
+  g_object_set_data_full (G_OBJECT (element), "gst123-profiler", probe, free_element_probe);
+
+  GstIterator *iterator = gst_element_iterate_pads (element);
+  gst_iterator_foreach (iterator, attach_pad_iterfunc, probe);
+  gst_iterator_free (iterator);
+
+  g_signal_connect (element, "pad-added", G_CALLBACK (pad_added), probe);
+}
+
+void
+ElementProfiler::attach_pad_iterfunc (const GValue *evalue, gpointer data)
+{
+  attach_pad (GST_PAD (g_value_get_object (evalue)), data);
+}
+
+void
+ElementProfiler::pad_added (GstElement *element, GstPad *pad, gpointer data)
+{
+  attach_pad (pad, data);
+}
+
+void
+ElementProfiler::attach_pad (GstPad *pad, gpointer data)
+{
+  if (GST_PAD_IS_SINK (pad))
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, sink_probe, data, NULL);
+  else if (GST_PAD_IS_SRC (pad))
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, src_probe, data, NULL);
+}
+
+GstPadProbeReturn
+ElementProfiler::sink_probe (GstPad *pad, GstPadProbeInfo *info, gpointer data)
+{
+  // this callback doesn't occur in main thread
+  ElementProbe *probe = static_cast<ElementProbe *> (data);
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  GstClockTime now = gst_util_get_timestamp();
+
+  GThread *thread = g_thread_self();
+
+  g_mutex_lock (&probe->mutex);
+  size_t i = 0;
+  while (i < probe->entry_times.size() && probe->entry_times[i].first != thread)
+    i++;
+  if (i < probe->entry_times.size())
+    probe->entry_times[i].second = now;
+  else
+    probe->entry_times.push_back (make_pair (thread, now));
+
+  if (buffer && GST_BUFFER_PTS_IS_VALID (buffer) && probe->in_flight.size() < MAX_IN_FLIGHT)
+    probe->in_flight.push_back (make_pair (GST_BUFFER_PTS (buffer), now));
+  g_mutex_unlock (&probe->mutex);
+
+  g_mutex_lock (&probe->profiler->mutex);
+  probe->stats->buffers++;
+  g_mutex_unlock (&probe->profiler->mutex);
+
+  return GST_PAD_PROBE_OK;
+}
+
+GstPadProbeReturn
+ElementProfiler::src_probe (GstPad *pad, GstPadProbeInfo *info, gpointer data)
+{
+  // this callback doesn't occur in main thread
+  ElementProbe *probe = static_cast<ElementProbe *> (data);
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  GstClockTime now = gst_util_get_timestamp();
+
+  GThread *thread = g_thread_self();
+
+  bool    have_proc = false;
+  guint64 proc_ns = 0;
+
+  bool    have_latency = false;
+  guint64 latency_ns = 0;
+
+  g_mutex_lock (&probe->mutex);
+  /* only a buffer pushed by the thread which entered the element measures processing time */
+  for (size_t i = 0; i < probe->entry_times.size(); i++)
+    {
+      if (probe->entry_times[i].first == thread)
+        {
+          proc_ns = now - probe->entry_times[i].second;
+          have_proc = true;
+          probe->entry_times.erase (probe->entry_times.begin() + i);
+          break;
+        }
+    }
+
+  if (buffer && GST_BUFFER_PTS_IS_VALID (buffer))
+    {
+      while (!probe->in_flight.empty() && probe->in_flight.front().first <= GST_BUFFER_PTS (buffer))
+        {
+          latency_ns = now - probe->in_flight.front().second;
+          have_latency = true;
+          probe->in_flight.pop_front();
+        }
+    }
+  g_mutex_unlock (&probe->mutex);
+
+  if (have_proc || have_latency)
+    {
+      Stats *stats = probe->stats;
+
+      g_mutex_lock (&probe->profiler->mutex);
+      if (have_proc)
+        {
+          stats->proc_count++;
+          stats->proc_ns += proc_ns;
+          stats->max_proc_ns = std::max (stats->max_proc_ns, proc_ns);
+        }
+      if (have_latency)
+        {
+          stats->latency_count++;
+          stats->latency_ns += latency_ns;
+          stats->max_latency_ns = std::max (stats->max_latency_ns, latency_ns);
+        }
+      g_mutex_unlock (&probe->profiler->mutex);
+    }
+  return GST_PAD_PROBE_OK;
+}
+
+vector<ElementProfiler::Stats>
+ElementProfiler::sorted_stats()
+{
+  vector<Stats> result;
+
+  g_mutex_lock (&mutex);
+  for (map<string, Stats *>::const_iterator si = stats.begin(); si != stats.end(); si++)
+    result.push_back (*si->second);
+  g_mutex_unlock (&mutex);
+
+  std::sort (result.begin(), result.end(), cmp_proc_time);
+  return result;
+}
+
+string
+ElementProfiler::format_top (guint n)
+{
+  vector<Stats> sorted = sorted_stats();
+  double elapsed = get_time() - start_time;
+
+  string result;
+  for (size_t i = 0; i < sorted.size() && i < n; i++)
+    {
+      const Stats& s = sorted[i];
+      if (s.proc_count == 0 || elapsed <= 0)
+        break;
+
+      result += string_printf ("%s%s %.1f%%", result.empty() ? "" : ", ", s.name.c_str(),
+                               s.proc_ns * 100.0 / GST_SECOND / elapsed);
+    }
+  if (result.empty())
+    return "";
+  return "Heaviest elements: " + result;
+}
+
+void
+ElementProfiler::print_summary()
+{
+  if (!attached)
+    return;
+
+  vector<Stats> sorted = sorted_stats();
+  double elapsed = get_time() - start_time;
+
+  Msg::print ("==================== gst123 element statistics ======================\n");
+  Msg::print ("%-24s %9s %6s %10s %10s %11s %11s\n",
+              "element", "buffers", "cpu%", "avg proc", "max proc", "avg latency", "max latency");
+  for (size_t i = 0; i < sorted.size(); i++)
+    {
+      const Stats& s = sorted[i];
+      double avg_proc_ms = s.proc_count ? s.proc_ns / 1e6 / s.proc_count : 0;
+      double avg_latency_ms = s.latency_count ? s.latency_ns / 1e6 / s.latency_count : 0;
+
+      Msg::print ("%-24s %9" G_GUINT64_FORMAT " %6.1f %7.3f ms %7.3f ms %8.3f ms %8.3f ms\n",
+                  s.name.c_str(), s.buffers,
+                  elapsed > 0 ? s.proc_ns * 100.0 / GST_SECOND / elapsed : 0.0,
+                  avg_proc_ms, s.max_proc_ns / 1e6, avg_latency_ms, s.max_latency_ns / 1e6);
+    }
+  Msg::print ("=====================================================================\n");
+}
+
+}
@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef GST123_PROFILER_H
+#define GST123_PROFILER_H
+
+#include <gst/gst.h>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace Gst123
+{
+
+/*
+ * Per-element processing time and latency measurement
+ *
+ * Buffer probes are attached to the pads of every element (bins excluded)
+ * in the pipeline. Processing time is the time between a buffer entering
+ * the sink pad and the next buffer leaving a src pad in the same thread.
+ * Latency is the time between a buffer entering the element and the buffer
+ * with the same timestamp leaving it, in any thread (so for elements with
+ * their own streaming thread, like queues, it includes the time queued).
+ *
+ * Statistics are accumulated by element factory name across all tracks.
+ */
+class ElementProfiler
+{
+public:
+  struct Stats
+  {
+    std::string name;
+    guint       instances;
+    guint64     buffers;
+    guint64     proc_count;
+    guint64     proc_ns;
+    guint64     max_proc_ns;
+    guint64     latency_count;
+    guint64     latency_ns;
+    guint64     max_latency_ns;
+
+    Stats();
+  };
+
+private:
+  GMutex                          mutex;
+  std::map<std::string, Stats *>  stats;
+  double                          start_time;
+  bool                            attached;
+
+  static void deep_element_added (GstBin *bin, GstBin *sub_bin, GstElement *element, gpointer data);
+  static void pad_added (GstElement *element, GstPad *pad, gpointer data);
+  static void attach_iterfunc (const GValue *evalue, gpointer data);
+  static void attach_pad_iterfunc (const GValue *evalue, gpointer data);
+  static void attach_pad (GstPad *pad, gpointer data);
+  static GstPadProbeReturn sink_probe (GstPad *pad, GstPadProbeInfo *info, gpointer data);
+  static GstPadProbeReturn src_probe (GstPad *pad, GstPadProbeInfo *info, gpointer data);
+
+  void attach_element (GstElement *element);
+  std::vector<Stats> sorted_stats();
+
+public:
+  ElementProfiler();
+  ~ElementProfiler();
+
+  void attach (GstElement *pipeline);
+  std::string format_top (guint n);
+  void print_summary();
+};
+
+}
+
+#endif
@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "qos.h"
+#include "utils.h"
+
+#include <algorithm>
+
+using std::string;
+
+namespace Gst123
+{
+
+QosStats::QosStats()
+{
+  reset();
+}
+
+void
+QosStats::reset()
+{
+  sources.clear();
+  jitter_count = 0;
+  jitter_sum_ns = 0;
+  max_jitter_ns = 0;
+  warned = false;
+}
+
+/* returns true if the message contained video frame statistics */
+bool
+QosStats::update (GstMessage *message)
+{
+  GstFormat format;
+  guint64   msg_processed, msg_dropped;
+
+  gst_message_parse_qos_stats (message, &format, &msg_processed, &msg_dropped);
+
+  /* audio sinks report samples (GST_FORMAT_DEFAULT), we only care about video frames */
+  if (format != GST_FORMAT_BUFFERS)
+    return false;
+
+  gchar *path = gst_object_get_path_string (GST_MESSAGE_SRC (message));
+  Counters& counters = sources[path ? path : ""];
+  g_free (path);
+
+  if (msg_processed < counters.processed || msg_dropped < counters.dropped)
+    {
+      /* element was flushed (seek), counters restarted */
+      counters.base_processed += counters.processed;
+      counters.base_dropped += counters.dropped;
+    }
+  counters.processed = msg_processed;
+  counters.dropped = msg_dropped;
+
+  gint64 jitter;
+  gst_message_parse_qos_values (message, &jitter, NULL, NULL);
+  if (jitter > 0)
+    {
+      jitter_count++;
+      jitter_sum_ns += jitter;
+      if (guint64 (jitter) > max_jitter_ns)
+        max_jitter_ns = jitter;
+    }
+  return true;
+}
+
+bool
+QosStats::have_data() const
+{
+  return total_processed() > 0 || total_dropped() > 0;
+}
+
+/* every element sees the same frames (minus those dropped before it), so the
+ * element which processed most frames counts them
+ */
+guint64
+QosStats::total_processed() const
+{
+  guint64 result = 0;
+  for (std::map<string, Counters>::const_iterator si = sources.begin(); si != sources.end(); si++)
+    result = std::max (result, si->second.base_processed + si->second.processed);
+  return result;
+}
+
+/* a frame is dropped by at most one element */
+guint64
+QosStats::total_dropped() const
+{
+  guint64 result = 0;
+  for (std::map<string, Counters>::const_iterator si = sources.begin(); si != sources.end(); si++)
+    result += si->second.base_dropped + si->second.dropped;
+  return result;
+}
+
+double
+QosStats::dropped_percent() const
+{
+  /* processed doesn't include the dropped frames */
+  guint64 total = total_processed() + total_dropped();
+  if (total == 0)
+    return 0;
+  return total_dropped() * 100.0 / total;
+}
+
+string
+QosStats::format_status() const
+{
+  return string_printf ("Dropped: %" G_GUINT64_FORMAT " frames (%.1f%%)", total_dropped(), dropped_percent());
+}
+
+string
+QosStats::format_summary() const
+{
+  double avg_jitter_ms = jitter_count ? jitter_sum_ns / 1e6 / jitter_count : 0;
+
+  return string_printf ("Video QoS: %" G_GUINT64_FORMAT " frames processed, %" G_GUINT64_FORMAT " dropped (%.1f%%), "
+                        "jitter avg %.1f ms, max %.1f ms",
+                        total_processed(), total_dropped(), dropped_percent(), avg_jitter_ms, max_jitter_ns / 1e6);
+}
+
+}
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef GST123_QOS_H
+#define GST123_QOS_H
+
+#include <gst/gst.h>
+#include <map>
+#include <string>
+
+namespace Gst123
+{
+
+/*
+ * Quality of service statistics for the video of one track
+ *
+ * Video sinks (and video decoders) post QoS messages when they drop frames
+ * that arrive too late; each element has its own processed/dropped counters,
+ * which restart after each flushing seek, so we accumulate them per element.
+ */
+struct QosStats
+{
+  struct Counters
+  {
+    guint64 processed;
+    guint64 dropped;
+    guint64 base_processed;   // counts before the last counter reset
+    guint64 base_dropped;
+
+    Counters() : processed (0), dropped (0), base_processed (0), base_dropped (0) {}
+  };
+  std::map<std::string, Counters> sources;   // indexed by element path
+
+  guint64 jitter_count;
+  guint64 jitter_sum_ns;
+  guint64 max_jitter_ns;
+  bool    warned;
+
+  QosStats();
+
+  void        reset();
+  bool        update (GstMessage *message);
+  bool        have_data() const;
+  guint64     total_processed() const;
+  guint64     total_dropped() const;
+  double      dropped_percent() const;
+  std::string format_status() const;
+  std::string format_summary() const;
+};
+
+}
+
+#endif
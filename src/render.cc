@@ -0,0 +1,252 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "render.h"
+#include "msg.h"
+#include "utils.h"
+
+using std::string;
+
+namespace Gst123
+{
+
+Render::Render() :
+  bin (NULL),
+  filesink (NULL),
+  m_per_track (false),
+  start_time (0),
+  rendered_ns (0)
+{
+}
+
+Render::~Render()
+{
+  if (bin)
+    gst_object_unref (bin);
+}
+
+static string
+uri_basename_noext (const string& uri)
+{
+  char *base;
+  char *filename = g_filename_from_uri (uri.c_str(), NULL, NULL);
+  if (filename)
+    {
+      base = g_path_get_basename (filename);
+      g_free (filename);
+    }
+  else
+    {
+      char *unescaped = g_uri_unescape_string (uri.c_str(), NULL);
+      base = g_path_get_basename (unescaped ? unescaped : uri.c_str());
+      g_free (unescaped);
+    }
+  string result = base;
+  g_free (base);
+
+  size_t dot_pos = result.rfind ('.');
+  if (dot_pos != string::npos && dot_pos > 0)
+    result.resize (dot_pos);
+  return result;
+}
+
+string
+Render::expand_pattern (const string& pattern, guint track_number, const string& uri)
+{
+  string result;
+
+  for (size_t i = 0; i < pattern.size(); i++)
+    {
+      if (pattern[i] == '%' && i + 1 < pattern.size())
+        {
+          char ch = pattern[++i];
+          if (ch == 'n')
+            result += string_printf ("%02u", track_number);
+          else if (ch == 'b')
+            result += uri_basename_noext (uri);
+          else if (ch == '%')
+            result += '%';
+          else
+            {
+              result += '%';
+              result += ch;
+            }
+        }
+      else
+        {
+          result += pattern[i];
+        }
+    }
+  return result;
+}
+
+bool
+Render::is_per_track_pattern (const string& pattern)
+{
+  return pattern.find ("%n") != string::npos || pattern.find ("%b") != string::npos;
+}
+
+string
+Render::encoder_for_filename (const string& filename)
+{
+  size_t dot_pos = filename.rfind ('.');
+  if (dot_pos == string::npos)
+    return "";
+
+  char *ext = g_ascii_strdown (filename.c_str() + dot_pos + 1, -1);
+  string extension = ext;
+  g_free (ext);
+
+  if (extension == "wav")
+    return "wavenc";
+  if (extension == "flac")
+    return "flacenc";
+  return "";
+}
+
+bool
+Render::init (const string& pattern, string& error)
+{
+  this->pattern = pattern;
+
+  encoder_name = encoder_for_filename (pattern);
+  if (encoder_name == "")
+    {
+      error = "unsupported render output format (use .wav or .flac): " + pattern;
+      return false;
+    }
+  GstElementFactory *factory = gst_element_factory_find (encoder_name.c_str());
+  if (!factory)
+    {
+      error = "GStreamer element " + encoder_name + " not found, can't render " + pattern;
+      return false;
+    }
+  gst_object_unref (factory);
+
+  m_per_track = is_per_track_pattern (pattern);
+
+  GstElement *convert  = gst_element_factory_make ("audioconvert", NULL);
+  GstElement *resample = gst_element_factory_make ("audioresample", NULL);
+  GstElement *encoder  = gst_element_factory_make (encoder_name.c_str(), NULL);
+  filesink = gst_element_factory_make ("filesink", NULL);
+  if (!convert || !resample || !encoder || !filesink)
+    {
+      error = "failed to create render pipeline elements";
+      return false;
+    }
+  g_object_set (G_OBJECT (filesink), "sync", FALSE, NULL);
+
+  bin = gst_bin_new ("renderbin");
+  gst_object_ref_sink (bin);
+  gst_bin_add_many (GST_BIN (bin), convert, resample, encoder, filesink, NULL);
+  if (m_per_track)
+    {
+      gst_element_link_many (convert, resample, encoder, filesink, NULL);
+    }
+  else
+    {
+      /* the encoder can't change the format in the middle of the file, so we
+       * need to convert all tracks to the same format for concatenation
+       */
+      GstElement *capsfilter = gst_element_factory_make ("capsfilter", NULL);
+      GstCaps *caps = gst_caps_from_string ("audio/x-raw, rate=(int)44100, channels=(int)2");
+      g_object_set (G_OBJECT (capsfilter), "caps", caps, NULL);
+      gst_caps_unref (caps);
+
+      gst_bin_add (GST_BIN (bin), capsfilter);
+      gst_element_link_many (convert, resample, capsfilter, encoder, filesink, NULL);
+
+      g_object_set (G_OBJECT (filesink), "location", pattern.c_str(), NULL);
+    }
+
+  GstPad *pad = gst_element_get_static_pad (convert, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, buffer_probe, this, NULL);
+  gst_element_add_pad (bin, gst_ghost_pad_new ("sink", pad));
+  gst_object_unref (pad);
+
+  return true;
+}
+
+GstPadProbeReturn
+Render::buffer_probe (GstPad *pad, GstPadProbeInfo *info, gpointer data)
+{
+  // this callback doesn't occur in main thread
+  Render *self = static_cast<Render *> (data);
+
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  if (buffer && GST_BUFFER_DURATION_IS_VALID (buffer))
+    self->rendered_ns += GST_BUFFER_DURATION (buffer);
+
+  return GST_PAD_PROBE_OK;
+}
+
+bool
+Render::enabled() const
+{
+  return bin != NULL;
+}
+
+bool
+Render::per_track() const
+{
+  return m_per_track;
+}
+
+GstElement *
+Render::sink() const
+{
+  return bin;
+}
+
+/* must be called while the pipeline is in GST_STATE_NULL */
+string
+Render::set_track (guint track_number, const string& uri)
+{
+  if (start_time == 0)
+    start_time = get_time();
+
+  if (!m_per_track)
+    return pattern;
+
+  string location = expand_pattern (pattern, track_number, uri);
+  g_object_set (G_OBJECT (filesink), "location", location.c_str(), NULL);
+  return location;
+}
+
+double
+Render::rendered_time() const
+{
+  return rendered_ns.load() * (1.0 / GST_SECOND);
+}
+
+void
+Render::print_summary()
+{
+  if (start_time == 0)
+    return;
+
+  double wall_time = get_time() - start_time;
+  double audio_time = rendered_time();
+
+  Msg::print ("Rendered %.2f seconds of audio in %.2f seconds (realtime factor %.1fx)\n",
+              audio_time, wall_time, wall_time > 0 ? audio_time / wall_time : 0.0);
+}
+
+}
@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef GST123_RENDER_H
+#define GST123_RENDER_H
+
+#include <gst/gst.h>
+#include <string>
+#include <atomic>
+
+namespace Gst123
+{
+
+/*
+ * Render audio into a file instead of the sound card
+ *
+ * The sink bin (audioconvert ! audioresample ! encoder ! filesink) is used
+ * as playbin audio-sink; since filesink doesn't sync against the clock, the
+ * playlist is rendered as fast as the cpu allows.
+ *
+ * The output filename is a pattern: if it contains %n (track number) or %b
+ * (basename of the input file), one output file per track is written,
+ * otherwise all tracks are concatenated into one file.
+ */
+class Render
+{
+  std::string           pattern;
+  std::string           encoder_name;
+  GstElement           *bin;
+  GstElement           *filesink;
+  bool                  m_per_track;
+  double                start_time;
+  std::atomic<guint64>  rendered_ns;
+
+  static GstPadProbeReturn buffer_probe (GstPad *pad, GstPadProbeInfo *info, gpointer data);
+
+public:
+  Render();
+  ~Render();
+
+  bool init (const std::string& pattern, std::string& error);
+  bool enabled() const;
+  bool per_track() const;
+  GstElement *sink() const;
+
+  std::string set_track (guint track_number, const std::string& uri);
+  double rendered_time() const;
+  void print_summary();
+
+  static bool is_per_track_pattern (const std::string& pattern);
+  static std::string expand_pattern (const std::string& pattern, guint track_number, const std::string& uri);
+  static std::string encoder_for_filename (const std::string& filename);
+};
+
+}
+
+#endif
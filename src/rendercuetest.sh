@@ -0,0 +1,33 @@
+#!/bin/sh
+# renders a cue sheet with two tracks into one file: the second track must
+# not truncate the output of the first one
+
+GST_LAUNCH=gst-launch-1.0
+command -v $GST_LAUNCH >/dev/null || { echo "rendercuetest: $GST_LAUNCH not found"; exit 77; }
+
+TMPDIR=$(mktemp -d) || exit 1
+trap 'rm -rf "$TMPDIR"' EXIT
+
+# 4 seconds of 44100 Hz stereo audio
+$GST_LAUNCH -q audiotestsrc num-buffers=40 samplesperbuffer=4410 ! \
+  audio/x-raw,format=S16LE,rate=44100,channels=2 ! wavenc ! filesink location="$TMPDIR/in.wav" || exit 1
+
+cat > "$TMPDIR/test.cue" <<EOC
+FILE "in.wav" WAVE
+  TRACK 01 AUDIO
+    TITLE "One"
+    INDEX 01 00:00:00
+  TRACK 02 AUDIO
+    TITLE "Two"
+    INDEX 01 00:02:00
+EOC
+
+./gst123 -q --render "$TMPDIR/out.wav" -@ "$TMPDIR/test.cue" < /dev/null || exit 1
+
+in_size=$(wc -c < "$TMPDIR/in.wav")
+out_size=$(wc -c < "$TMPDIR/out.wav")
+if [ $((out_size * 100)) -lt $((in_size * 95)) ]; then
+  echo "rendercuetest: FAILED: rendered $out_size bytes, expected about $in_size"
+  exit 1
+fi
+exit 0
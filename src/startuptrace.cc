@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+#include "startuptrace.h"
+#include "options.h"
+#include "msg.h"
+#include "utils.h"
+
+using std::string;
+
+namespace Gst123
+{
+
+static StartupTrace *instance = 0;
+
+StartupTrace&
+StartupTrace::the()
+{
+  if (!instance)
+    instance = new StartupTrace();
+
+  return *instance;
+}
+
+StartupTrace::StartupTrace() :
+  start_time (g_get_monotonic_time()),
+  finished (false)
+{
+}
+
+/* ends the current phase (if any) and starts the next one */
+void
+StartupTrace::phase (const char *name)
+{
+  if (finished)
+    return;
+
+  gint64 now = g_get_monotonic_time();
+  if (!phases.empty())
+    phases.back().end = now;
+
+  Phase p;
+  p.name = name;
+  p.start = now;
+  p.end = 0;
+  phases.push_back (p);
+}
+
+bool
+StartupTrace::write_json (const string& filename, string& error)
+{
+  FILE *file = fopen (filename.c_str(), "w");
+  if (!file)
+    {
+      error = strerror (errno);
+      return false;
+    }
+  fprintf (file, "{\"traceEvents\":[\n");
+  for (size_t i = 0; i < phases.size(); i++)
+    {
+      const Phase& p = phases[i];
+      fprintf (file, "  {\"name\":%s,\"cat\":\"startup\",\"ph\":\"X\",\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT
+               ",\"pid\":%d,\"tid\":1}%s\n",
+               json_string (p.name).c_str(), p.start - start_time, p.end - p.start, int (getpid()),
+               (i + 1 < phases.size()) ? "," : "");
+    }
+  fprintf (file, "],\"displayTimeUnit\":\"ms\"}\n");
+
+  if (fclose (file) != 0)
+    {
+      error = strerror (errno);
+      return false;
+    }
+  return true;
+}
+
+/* ends the last phase and prints/writes the trace (only the first call has an effect) */
+void
+StartupTrace::finish()
+{
+  if (finished)
+    return;
+
+  if (!phases.empty())
+    phases.back().end = g_get_monotonic_time();
+  finished = true;
+
+  Options& options = Options::the();
+  if (options.startup_trace)
+    {
+      Msg::print ("\n==================== gst123 startup trace ===========================\n");
+      Msg::print ("%10s %10s   %s\n", "start ms", "duration", "phase");
+      for (size_t i = 0; i < phases.size(); i++)
+        {
+          const Phase& p = phases[i];
+          Msg::print ("%10.1f %10.1f   %s\n", (p.start - start_time) / 1000.0, (p.end - p.start) / 1000.0, p.name.c_str());
+        }
+      if (!phases.empty())
+        Msg::print ("%10.1f %10s   %s\n", (phases.back().end - start_time) / 1000.0, "", "total");
+      Msg::print ("=====================================================================\n");
+    }
+  if (options.startup_trace_json)
+    {
+      string error;
+      if (!write_json (options.startup_trace_json, error))
+        g_printerr ("gst123: can't write startup trace %s: %s\n", options.startup_trace_json, error.c_str());
+    }
+}
+
+}
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef GST123_STARTUP_TRACE_H
+#define GST123_STARTUP_TRACE_H
+
+#include <glib.h>
+#include <string>
+#include <vector>
+
+namespace Gst123
+{
+
+/*
+ * Timeline of the startup phases, until the first track is playing
+ *
+ * Phases are always recorded (this is cheap), because the first phases run
+ * before the command line options are known. The timeline is printed with
+ * --startup-trace, and written as Chrome trace event JSON (which can be
+ * loaded into chrome://tracing or Perfetto) with --startup-trace-json.
+ */
+class StartupTrace
+{
+  struct Phase
+  {
+    std::string name;
+    gint64      start;   // monotonic time in microseconds
+    gint64      end;
+  };
+  gint64              start_time;
+  std::vector<Phase>  phases;
+  bool                finished;
+
+  StartupTrace();
+
+  bool write_json (const std::string& filename, std::string& error);
+
+public:
+  static StartupTrace& the();   // Singleton
+
+  void phase (const char *name);
+  void finish();
+};
+
+}
+
+#endif
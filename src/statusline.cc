@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <algorithm>
+
+#include <glib.h>
+
+#include "statusline.h"
+#include "options.h"
+
+using std::string;
+
+namespace Gst123
+{
+
+StatusLine::StatusLine() :
+  length (0),
+  width (80)
+{
+}
+
+void
+StatusLine::write_out (const string& data)
+{
+  /* other output uses stdio, so we need to flush it first to keep the order */
+  fflush (stdout);
+
+  const char *p = data.data();
+  size_t      todo = data.size();
+  while (todo > 0)
+    {
+      ssize_t n = write (STDOUT_FILENO, p, todo);
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          return;
+        }
+      p += n;
+      todo -= n;
+    }
+}
+
+/* shows text, the cursor stays at the start of the line */
+void
+StatusLine::update (const string& text)
+{
+  if (text == line || Options::the().quiet)
+    return;
+
+  /* the last column is not used, to avoid an automatic line wrap */
+  string visible = text;
+  size_t visible_length = g_utf8_strlen (visible.c_str(), -1);
+  size_t max_length = width - 1;
+  if (visible_length > max_length)
+    {
+      visible.resize (g_utf8_offset_to_pointer (visible.c_str(), max_length) - visible.c_str());
+      visible_length = max_length;
+    }
+
+  string data = "\r" + visible;
+  if (visible_length < length)
+    data += string (length - visible_length, ' ');
+  data += "\r";
+
+  write_out (data);
+  line = text;
+  length = visible_length;
+}
+
+/* erases the status line, to print other messages */
+void
+StatusLine::clear()
+{
+  if (length == 0 || Options::the().quiet)
+    return;
+
+  write_out ("\r" + string (length, ' ') + "\r");
+  keep();
+}
+
+/* leaves the current text on the screen (for instance when quitting) */
+void
+StatusLine::keep()
+{
+  line = "";
+  length = 0;
+}
+
+/* terminal was resized: the old text is erased, the next update() uses the new layout */
+void
+StatusLine::set_width (int new_width)
+{
+  if (new_width == width)
+    return;
+
+  /* if the terminal got smaller, the text beyond the new width is gone */
+  length = std::min<size_t> (length, new_width - 1);
+  clear();
+  width = new_width;
+}
+
+}
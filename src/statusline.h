@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef GST123_STATUS_LINE_H
+#define GST123_STATUS_LINE_H
+
+#include <string>
+
+namespace Gst123
+{
+
+/*
+ * Status line at the bottom of the terminal output
+ *
+ * The line is only written if the visible text changes, and each update is
+ * written with a single write() call. Since the old text is known, only as
+ * many blanks as needed are written to erase it. Text is truncated to the
+ * terminal width, as a line that wraps can't be overwritten using '\r'.
+ */
+class StatusLine
+{
+  std::string line;     // currently visible text
+  size_t      length;   // visible text length in characters
+  int         width;
+
+  void write_out (const std::string& data);
+
+public:
+  StatusLine();
+
+  void update (const std::string& text);
+  void clear();
+  void keep();
+  void set_width (int width);
+};
+
+}
+
+#endif
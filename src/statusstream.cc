@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <glib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "statusstream.h"
+#include "utils.h"
+
+using std::string;
+
+namespace Gst123
+{
+
+/* maximum amount of data we keep if the reader is too slow */
+static const size_t MAX_PENDING = 64 * 1024;
+
+StatusStream::StatusStream() :
+  fd (-1),
+  dropped_lines (0),
+  write_watch_id (0)
+{
+}
+
+bool
+StatusStream::init (int new_fd, string& error)
+{
+  /* stdin/stdout/stderr are used by the player itself (terminal) */
+  if (new_fd <= 2)
+    {
+      error = string_printf ("status fd %d: must not be stdin, stdout or stderr", new_fd);
+      return false;
+    }
+
+  struct stat st;
+  if (fstat (new_fd, &st) < 0)
+    {
+      error = string_printf ("status fd %d: %s", new_fd, strerror (errno));
+      return false;
+    }
+  bool can_block = S_ISFIFO (st.st_mode) || S_ISSOCK (st.st_mode);
+  if (!can_block && !S_ISREG (st.st_mode))
+    {
+      error = string_printf ("status fd %d: not a pipe, socket or regular file", new_fd);
+      return false;
+    }
+
+  int dup_fd = fcntl (new_fd, F_DUPFD_CLOEXEC, 3);
+  if (dup_fd < 0)
+    {
+      error = string_printf ("status fd %d: %s", new_fd, strerror (errno));
+      return false;
+    }
+  /* O_NONBLOCK belongs to the open file, so it also affects the caller's fd:
+   * only set it for pipes and sockets, which are meant for the status events;
+   * writing to a regular file doesn't block for long anyway
+   */
+  int flags = fcntl (dup_fd, F_GETFL);
+  if (can_block && (flags < 0 || fcntl (dup_fd, F_SETFL, flags | O_NONBLOCK) < 0))
+    {
+      error = string_printf ("status fd %d: can't set non-blocking mode: %s", new_fd, strerror (errno));
+      close (dup_fd);
+      return false;
+    }
+  /* a reader that went away should not kill the player */
+  signal (SIGPIPE, SIG_IGN);
+
+  fd = dup_fd;
+  return true;
+}
+
+bool
+StatusStream::enabled() const
+{
+  return fd >= 0;
+}
+
+void
+StatusStream::flush_pending()
+{
+  while (fd >= 0 && !pending.empty())
+    {
+      ssize_t n = write (fd, pending.data(), pending.size());
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+              /* reader closed the fd or similar: stop sending events */
+              if (write_watch_id)
+                {
+                  g_source_remove (write_watch_id);   // the watch must not outlive the fd
+                  write_watch_id = 0;
+                }
+              close (fd);
+              fd = -1;
+              pending.clear();
+            }
+          break;
+        }
+      pending.erase (0, n);
+    }
+  if (fd >= 0 && !pending.empty() && !write_watch_id)
+    {
+      GIOChannel *channel = g_io_channel_unix_new (fd);
+      write_watch_id = g_io_add_watch (channel, GIOCondition (G_IO_OUT | G_IO_ERR | G_IO_HUP), write_cb, this);
+      g_io_channel_unref (channel);
+    }
+}
+
+/* keeps writing pending data without waiting for the next event */
+gboolean
+StatusStream::write_cb (GIOChannel *source, GIOCondition condition, gpointer data)
+{
+  StatusStream *self = static_cast<StatusStream *> (data);
+
+  self->flush_pending();
+  if (self->fd >= 0 && !self->pending.empty())
+    return TRUE;
+
+  self->write_watch_id = 0;
+  return FALSE;
+}
+
+void
+StatusStream::send (const char *event, const string& fields)
+{
+  if (fd < 0)
+    return;
+
+  string line = "{\"event\":" + json_string (event);
+  if (!fields.empty())
+    line += "," + fields;
+  line += "}\n";
+
+  flush_pending();
+  if (fd < 0)
+    return;
+
+  if (pending.size() + line.size() > MAX_PENDING)
+    {
+      dropped_lines++;
+      return;
+    }
+  if (dropped_lines)
+    {
+      /* let the reader know that it missed some events */
+      pending += string_printf ("{\"event\":\"overflow\",\"dropped\":%" G_GUINT64_FORMAT "}\n", dropped_lines);
+      dropped_lines = 0;
+    }
+  pending += line;
+  flush_pending();
+}
+
+}
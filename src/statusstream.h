@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef GST123_STATUS_STREAM_H
+#define GST123_STATUS_STREAM_H
+
+#include <string>
+#include <glib.h>
+
+namespace Gst123
+{
+
+/*
+ * Machine readable status output (--status-fd)
+ *
+ * Each event is written as one JSON object per line, for instance
+ *   {"event":"state","state":"playing"}
+ * The file descriptor is non-blocking: if the reader doesn't keep up, lines
+ * are buffered up to a limit and dropped afterwards, so a slow supervisor
+ * can never stall playback. Buffered lines are written from the main loop
+ * as soon as the reader catches up.
+ */
+class StatusStream
+{
+  int          fd;
+  std::string  pending;
+  guint64      dropped_lines;
+  guint        write_watch_id;   // waits until the fd is writable, while data is pending
+
+  void flush_pending();
+  static gboolean write_cb (GIOChannel *source, GIOCondition condition, gpointer data);
+
+public:
+  StatusStream();
+
+  bool init (int fd, std::string& error);
+  bool enabled() const;
+
+  /* fields is a list of already formatted JSON members, like "\"index\":1" */
+  void send (const char *event, const std::string& fields = "");
+};
+
+}
+
+#endif
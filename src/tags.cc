@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2006-2010 Stefan Westerfeld
+ * Copyright (C) 2010 أحمد المحمودي (Ahmed El-Mahmoudy)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <string.h>
+#include "tags.h"
+
+namespace Gst123
+{
+
+void
+collect_tags (const GstTagList *tag_list,
+              const gchar *tag,
+	      gpointer user_data)
+{
+  Tags& tags = *(Tags *) user_data;
+  char *value;
+  if (strcmp (tag, GST_TAG_TITLE) == 0 && gst_tag_list_get_string (tag_list, GST_TAG_TITLE, &value))
+    tags.title = value;
+  if (strcmp (tag, GST_TAG_ARTIST) == 0 && gst_tag_list_get_string (tag_list, GST_TAG_ARTIST, &value))
+    tags.artist = value;
+  if (strcmp (tag, GST_TAG_ALBUM) == 0 && gst_tag_list_get_string (tag_list, GST_TAG_ALBUM, &value))
+    tags.album = value;
+  if (strcmp (tag, GST_TAG_GENRE) == 0 && gst_tag_list_get_string (tag_list, GST_TAG_GENRE, &value))
+    tags.genre = value;
+  if (strcmp (tag, GST_TAG_COMMENT) == 0 && gst_tag_list_get_string (tag_list, GST_TAG_COMMENT, &value))
+    tags.comment = value;
+  if (strcmp (tag, GST_TAG_AUDIO_CODEC) == 0 && gst_tag_list_get_string (tag_list, GST_TAG_AUDIO_CODEC, &value))
+    tags.codec = value;
+  if (strcmp (tag, GST_TAG_BITRATE) == 0)
+    gst_tag_list_get_uint (tag_list, GST_TAG_BITRATE, &tags.bitrate);
+  if (strcmp (tag, GST_TAG_VIDEO_CODEC) == 0 && gst_tag_list_get_string (tag_list, GST_TAG_VIDEO_CODEC, &value))
+    tags.vcodec = value;
+
+  if (strcmp (tag, GST_TAG_DATE) == 0)
+    {
+      GDate *date = NULL;
+      gst_tag_list_get_date (tag_list, GST_TAG_DATE, &date);
+
+      char outstr[200];
+      if (g_date_strftime (outstr, sizeof (outstr), "%Y", date))
+	tags.date = outstr;
+      g_date_free (date);
+    }
+}
+
+}
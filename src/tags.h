@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2006-2010 Stefan Westerfeld
+ * Copyright (C) 2010 أحمد المحمودي (Ahmed El-Mahmoudy)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef GST123_TAGS_H
+#define GST123_TAGS_H
+
+#include <gst/gst.h>
+#include <string>
+
+namespace Gst123
+{
+
+struct Tags
+{
+  double timestamp;
+  std::string title;
+  std::string artist;
+  std::string album;
+  std::string date;
+  std::string comment;
+  std::string genre;
+  std::string codec;
+  std::string vcodec;
+  guint bitrate;
+
+  Tags() : timestamp (-1), bitrate (0)
+  {
+  }
+};
+
+void collect_tags (const GstTagList *tag_list, const gchar *tag, gpointer user_data);
+
+}
+
+#endif
@@ -27,8 +27,10 @@
 
 #include <vector>
 #include <map>
+#include <algorithm>
 
 #include "terminal.h"
+#include "configfile.h"
 
 using std::vector;
 using std::string;
@@ -41,21 +43,59 @@ static Terminal *terminal_instance;
 
 static GPollFD stdin_poll_fd = { 0, G_IO_IN, 0 };
 
-static gboolean
-stdin_prepare (GSource    *source,
-               gint       *timeout)
+/* time to wait for the rest of an escape sequence before decoding bytes as typed */
+static const int PARTIAL_TIMEOUT_MS = 100;
+
+Terminal::KeyTrieNode::KeyTrieNode() :
+  key (0),
+  prefix (false)
+{
+  std::fill (child, child + 256, 0);
+}
+
+Terminal::Terminal() :
+  key_trie (1),
+  ring_start (0),
+  ring_len (0),
+  partial_time (0),
+  context (NULL),
+  stdin_eof (false),
+  stdin_is_tty (false),
+  key_handler (NULL)
+{
+}
+
+int
+Terminal::partial_timeout_ms()
+{
+  if (!partial_time)
+    return -1;
+
+  gint64 elapsed_ms = (g_get_monotonic_time() - partial_time) / 1000;
+  return std::max<gint64> (PARTIAL_TIMEOUT_MS - elapsed_ms, 0);
+}
+
+bool
+Terminal::partial_timeout_expired()
 {
-  *timeout = -1;
-  return FALSE;
+  return partial_timeout_ms() == 0;
 }
 
-static gboolean
-stdin_check (GSource *source)
+gboolean
+Terminal::stdin_prepare (GSource    *source,
+                         gint       *timeout)
+{
+  *timeout = terminal_instance->partial_timeout_ms();
+  return *timeout == 0;
+}
+
+gboolean
+Terminal::stdin_check (GSource *source)
 {
-  if (stdin_poll_fd.revents & G_IO_IN)
+  if (!terminal_instance->stdin_eof && (stdin_poll_fd.revents & (G_IO_IN | G_IO_HUP)))
     return TRUE;
   else
-    return FALSE;
+    return terminal_instance->partial_timeout_expired();
 }
 
 gboolean
@@ -63,17 +103,21 @@ Terminal::stdin_dispatch (GSource    *source,
                           GSourceFunc callback,
                           gpointer    user_data)
 {
-  terminal_instance->read_stdin();
+  if (!terminal_instance->stdin_eof && (stdin_poll_fd.revents & (G_IO_IN | G_IO_HUP)))
+    terminal_instance->read_stdin();
+
+  /* after the timeout, an incomplete escape sequence is decoded as individual bytes */
+  bool flush = terminal_instance->partial_timeout_expired();
 
   int key;
   do
     {
-      key = terminal_instance->getchar();
+      key = terminal_instance->getchar (flush);
 
       if (key > 0)
-        terminal_instance->key_handler->process_input (key);
+        terminal_instance->key_handler->process_input (ConfigFile::the().map_key (key));
     }
-  while (key > 0);
+  while (key >= 0);
 
   return TRUE;
 }
@@ -102,7 +146,7 @@ Terminal::init_terminal()
   struct termios tio_new = tio_orig;
   tio_new.c_lflag &= ~(ICANON|ECHO); /* Clear ICANON and ECHO. */
   tio_new.c_cc[VMIN] = 0;
-  tio_new.c_cc[VTIME] = 1; /* 0.1 seconds */
+  tio_new.c_cc[VTIME] = 0; /* don't wait: we only read if poll() says input is available */
   tcsetattr (0, TCSANOW, &tio_new);
 
   // enable keypad_xmit
@@ -110,12 +154,33 @@ Terminal::init_terminal()
   fflush (stdout);
 }
 
+void
+Terminal::add_key_sequence (const string& seq, int handler)
+{
+  int node = 0;
+
+  for (size_t i = 0; i < seq.size(); i++)
+    {
+      unsigned char c = seq[i];
+
+      if (!key_trie[node].child[c])
+        {
+          key_trie[node].child[c] = key_trie.size();
+          key_trie[node].prefix = true;
+          key_trie.push_back (KeyTrieNode());
+        }
+      node = key_trie[node].child[c];
+    }
+  if (node)
+    key_trie[node].key = handler;
+}
+
 void
 Terminal::bind_key (const char *key, int handler)
 {
   char *ret = tgetstr (const_cast<char *> (key), &term_p);
   if (ret)
-    keys[ret] = handler;
+    add_key_sequence (ret, handler);
 }
 
 void
@@ -123,6 +188,7 @@ Terminal::init (GMainLoop *loop, KeyHandler *key_handler)
 {
   terminal_instance = this;
   this->key_handler = key_handler;
+  stdin_is_tty = isatty (0);
 
   const char *termtype = NULL;
   termtype = getenv ("TERM");
@@ -144,11 +210,20 @@ Terminal::init (GMainLoop *loop, KeyHandler *key_handler)
   bind_key ("kP", KEY_HANDLER_PAGE_UP);
   bind_key ("kN", KEY_HANDLER_PAGE_DOWN);
 
+  // some terminals ignore keypad xmit mode, so accept the ANSI sequences, too
+  add_key_sequence ("\033[A", KEY_HANDLER_UP);
+  add_key_sequence ("\033[B", KEY_HANDLER_DOWN);
+  add_key_sequence ("\033[D", KEY_HANDLER_LEFT);
+  add_key_sequence ("\033[C", KEY_HANDLER_RIGHT);
+  add_key_sequence ("\033[5~", KEY_HANDLER_PAGE_UP);
+  add_key_sequence ("\033[6~", KEY_HANDLER_PAGE_DOWN);
+
   // add mainloop source for keys
   static GSourceFuncs source_funcs = { stdin_prepare, stdin_check, stdin_dispatch, };
+  context = g_main_loop_get_context (loop);
   GSource *source = g_source_new (&source_funcs, sizeof (GSource));
-  g_source_attach (source, g_main_loop_get_context (loop));
-  g_main_context_add_poll (g_main_loop_get_context (loop), &stdin_poll_fd, G_PRIORITY_DEFAULT);
+  g_source_attach (source, context);
+  g_main_context_add_poll (context, &stdin_poll_fd, G_PRIORITY_DEFAULT);
 
   signal (SIGCONT, signal_sig_cont);
 }
@@ -164,46 +239,89 @@ Terminal::end()
 void
 Terminal::read_stdin()
 {
-  char buffer[1024];
-  int r = read (0, buffer, 1024);
-  for (int bpos = 0; bpos < r; bpos++)
+  unsigned char buffer[1024];
+
+  size_t space = std::min<size_t> (sizeof (buffer), RING_SIZE - ring_len);
+  int r = read (0, buffer, space);
+
+  /* with VMIN = 0, reading a terminal returns 0 if no input is available (for
+   * instance if another process read it first), so there it only means end of
+   * input if the terminal was hung up
+   */
+  bool eof = (r == 0 && space > 0 && (!stdin_is_tty || (stdin_poll_fd.revents & G_IO_HUP)));
+  if (eof)
     {
-      int c = (unsigned char) buffer[bpos];
-      chars.push_back (c);
+      /* end of input (for instance stdin redirected from a file): stop polling, otherwise
+       * poll() would report stdin as readable forever and we'd busy loop
+       */
+      g_main_context_remove_poll (context, &stdin_poll_fd);
+      stdin_poll_fd.revents = 0;
+      stdin_eof = true;
+      return;
     }
+  if (r > 0)
+    add_input (buffer, r);
+}
+
+/* appends input to the ring buffer; returns how many bytes fit */
+size_t
+Terminal::add_input (const unsigned char *data, size_t len)
+{
+  len = std::min<size_t> (len, RING_SIZE - ring_len);
+  for (size_t i = 0; i < len; i++)
+    ring[(ring_start + ring_len++) % RING_SIZE] = data[i];
+
+  return len;
 }
 
+/* returns the next key, or -1 if no (complete) key is available */
 int
-Terminal::getchar()
+Terminal::getchar (bool flush)
 {
-  for (;;)
+  if (ring_len == 0)
     {
-      if (chars.empty())
-        return -1;
+      partial_time = 0;
+      return -1;
+    }
 
-      // interpret escape sequences at the start of the chars buffer
-      for (map<string, int>::iterator ki = keys.begin(); ki != keys.end(); ki++)
+  // find the longest escape sequence at the start of the buffer
+  int    node = 0;
+  int    match_key = 0;
+  size_t match_len = 0;
+  size_t i;
+  for (i = 0; i < ring_len; i++)
+    {
+      node = key_trie[node].child[ring[(ring_start + i) % RING_SIZE]];
+      if (!node)
+        break;
+
+      if (key_trie[node].key)
         {
-          const string& esc_seq = ki->first;
-
-          if (esc_seq.size() <= chars.size())
-            {
-              bool match = true;
-              for (size_t i = 0; i < esc_seq.size(); i++)
-                {
-                  if (esc_seq[i] != chars[i])
-                    match = false;
-                }
-              if (match)
-                {
-                  chars.erase (chars.begin(), chars.begin() + esc_seq.size());
-                  chars.insert (chars.begin(), ki->second);
-                }
-            }
+          match_key = key_trie[node].key;
+          match_len = i + 1;
         }
-      // return one interpreted char
-      int rc = *chars.begin();
-      chars.erase (chars.begin());
-      return rc;
     }
+  if (i == ring_len && key_trie[node].prefix && !flush)
+    {
+      // all input is the start of an escape sequence: wait for the rest
+      if (!partial_time)
+        partial_time = g_get_monotonic_time();
+      return -1;
+    }
+  partial_time = 0;
+
+  // return one interpreted char
+  int key;
+  if (match_len)
+    {
+      key = match_key;
+    }
+  else
+    {
+      key = ring[ring_start];
+      match_len = 1;
+    }
+  ring_start = (ring_start + match_len) % RING_SIZE;
+  ring_len -= match_len;
+  return key;
 }
@@ -31,25 +31,52 @@
 
 class Terminal
 {
+  /* escape sequence decoder: trie with one node per sequence prefix, node 0 is the root */
+  struct KeyTrieNode
+  {
+    int  key;           // key code if a sequence ends here, 0 otherwise
+    bool prefix;        // true if longer sequences start with this one
+    int  child[256];    // index of the next node for each input byte, 0 if none
+
+    KeyTrieNode();
+  };
+  enum { RING_SIZE = 4096 };
+
   struct termios             tio_orig;
   std::string                terminal_type;
-  std::vector<int>           chars;
-  std::map<std::string, int> keys;
+  std::vector<KeyTrieNode>   key_trie;
+  unsigned char              ring[RING_SIZE];
+  size_t                     ring_start;
+  size_t                     ring_len;
+  gint64                     partial_time;   // when an incomplete escape sequence was seen, 0 if none
+  GMainContext              *context;
+  bool                       stdin_eof;
+  bool                       stdin_is_tty;
 
   KeyHandler                *key_handler;
 
+  static gboolean stdin_prepare (GSource *source, gint *timeout);
+  static gboolean stdin_check (GSource *source);
   static gboolean stdin_dispatch (GSource *source, GSourceFunc callback, gpointer user_data);
   static void signal_sig_cont (int);
 
   void read_stdin();
-  int getchar();
+  bool partial_timeout_expired();
+  int partial_timeout_ms();
   void init_terminal();
   void bind_key (const char *key, int handler);
   void print_term (const char *key);
 
 public:
+  Terminal();
+
   void init (GMainLoop *loop, KeyHandler *key_handler);
   void end();
+
+  /* input decoding, which works without a terminal (used by terminalbench) */
+  void add_key_sequence (const std::string& seq, int handler);
+  size_t add_input (const unsigned char *data, size_t len);
+  int getchar (bool flush);
 };
 
 #endif
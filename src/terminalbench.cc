@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* measures how fast a burst of terminal input (typed keys mixed with cursor
+ * key escape sequences, like from key repeat or a paste) is decoded
+ */
+
+#include "terminal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+using std::string;
+
+int
+main (int argc, char **argv)
+{
+  size_t total_bytes = (argc > 1) ? atol (argv[1]) : 64 * 1024 * 1024;
+
+  Terminal terminal;
+
+  /* the sequences of a typical xterm (keypad transmit mode) and the ANSI ones */
+  const struct { const char *seq; int key; } sequences[] = {
+    { "\033OA", KEY_HANDLER_UP },
+    { "\033OB", KEY_HANDLER_DOWN },
+    { "\033OD", KEY_HANDLER_LEFT },
+    { "\033OC", KEY_HANDLER_RIGHT },
+    { "\033[A", KEY_HANDLER_UP },
+    { "\033[B", KEY_HANDLER_DOWN },
+    { "\033[D", KEY_HANDLER_LEFT },
+    { "\033[C", KEY_HANDLER_RIGHT },
+    { "\033[5~", KEY_HANDLER_PAGE_UP },
+    { "\033[6~", KEY_HANDLER_PAGE_DOWN },
+  };
+  const size_t n_sequences = sizeof (sequences) / sizeof (sequences[0]);
+  for (size_t i = 0; i < n_sequences; i++)
+    terminal.add_key_sequence (sequences[i].seq, sequences[i].key);
+
+  /* every fourth key is an escape sequence */
+  string input;
+  size_t expected_keys = 0;
+  while (input.size() < total_bytes)
+    {
+      if (expected_keys % 4 == 3)
+        input += sequences[expected_keys % n_sequences].seq;
+      else
+        input += "abcdefghijklmnopqrstuvwxyz +-/"[expected_keys % 30];
+      expected_keys++;
+    }
+
+  /* feed the input in chunks of the size read_stdin() uses, so that sequences
+   * are split across chunks, too
+   */
+  const unsigned char *data = reinterpret_cast<const unsigned char *> (input.data());
+  size_t pos = 0, keys = 0;
+  gint64 start_time = g_get_monotonic_time();
+  while (pos < input.size())
+    {
+      pos += terminal.add_input (data + pos, std::min<size_t> (1024, input.size() - pos));
+      while (terminal.getchar (false) >= 0)
+        keys++;
+    }
+  while (terminal.getchar (true) >= 0)
+    keys++;
+  double seconds = (g_get_monotonic_time() - start_time) / 1e6;
+
+  if (keys != expected_keys)
+    {
+      fprintf (stderr, "terminalbench: decoded %zu keys, expected %zu\n", keys, expected_keys);
+      return 1;
+    }
+  printf ("decoded %zu bytes (%zu keys) in %.3f s: %.1f MB/s, %.1f Mkeys/s\n",
+          input.size(), keys, seconds, input.size() / seconds / 1e6, keys / seconds / 1e6);
+  return 0;
+}
@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <algorithm>
+
+#include "trackswitch.h"
+#include "metrics.h"
+#include "utils.h"
+
+using std::string;
+using std::vector;
+
+namespace Gst123
+{
+
+TrackSwitchStats::TrackSwitchStats() :
+  start_time (0)
+{
+  for (int p = 0; p < N_PHASES; p++)
+    marks[p] = 0;
+}
+
+const char *
+TrackSwitchStats::phase_name (Phase phase)
+{
+  switch (phase)
+    {
+      case TYPE_DETECTION:  return "type detection";
+      case TEARDOWN:        return "state teardown";
+      case URI_SET:         return "uri set";
+      case STREAM_START:    return "stream start";
+      case PREROLL:         return "preroll";
+      case PLAYING:         return "playing";
+      default:              return "?";
+    }
+}
+
+/* called from main thread */
+void
+TrackSwitchStats::start()
+{
+  for (int p = 0; p < N_PHASES; p++)
+    marks[p] = 0;
+  start_time = gst_util_get_timestamp();
+}
+
+/* may be called from any thread, only the first mark of each phase counts */
+void
+TrackSwitchStats::mark (Phase phase)
+{
+  if (start_time == 0)
+    return;
+
+  GstClockTime expected = 0;
+  marks[phase].compare_exchange_strong (expected, gst_util_get_timestamp());
+}
+
+bool
+TrackSwitchStats::complete() const
+{
+  return start_time != 0 && marks[PLAYING] != 0;
+}
+
+/* called from main thread, once the track is playing */
+void
+TrackSwitchStats::finish()
+{
+  if (!complete())
+    return;
+
+  /* each phase lasts from the end of the previous phase (that was reached) to its own end */
+  GstClockTime last = start_time;
+  for (int p = 0; p < N_PHASES; p++)
+    {
+      GstClockTime t = marks[p];
+      if (t == 0)
+        continue;
+
+      samples[p].push_back (t > last ? (t - last) / 1e6 : 0);
+      last = std::max (last, t);
+    }
+  double total_ms = (marks[PLAYING] - start_time) / 1e6;
+  total_samples.push_back (total_ms);
+  Metrics::the().track_transition_seconds.observe (total_ms / 1000);
+  start_time = 0;
+}
+
+static double
+percentile (vector<double> values, double p)
+{
+  std::sort (values.begin(), values.end());
+  size_t index = std::min<size_t> (values.size() * p, values.size() - 1);
+  return values[index];
+}
+
+static string
+format_row (const char *name, const vector<double>& values)
+{
+  if (values.empty())
+    return string_printf ("%-16s %6d\n", name, 0);
+
+  double sum = 0;
+  for (size_t i = 0; i < values.size(); i++)
+    sum += values[i];
+
+  return string_printf ("%-16s %6zu %9.1f %9.1f %9.1f %9.1f\n", name, values.size(), sum / values.size(),
+                        percentile (values, 0.5), percentile (values, 0.9), percentile (values, 1.0));
+}
+
+string
+TrackSwitchStats::format() const
+{
+  string result;
+
+  result += "==================== gst123 track switch times ======================\n";
+  result += string_printf ("%-16s %6s %9s %9s %9s %9s\n", "phase", "count", "avg ms", "median", "90%", "max");
+  for (int p = 0; p < N_PHASES; p++)
+    result += format_row (phase_name (Phase (p)), samples[p]);
+  result += format_row ("total", total_samples);
+
+  /* histogram of the total switch time, with power of two buckets */
+  if (!total_samples.empty())
+    {
+      vector<int> buckets;
+      for (size_t i = 0; i < total_samples.size(); i++)
+        {
+          size_t b = 0;
+          while (total_samples[i] >= (1 << b) && b < 20)
+            b++;
+          if (buckets.size() <= b)
+            buckets.resize (b + 1);
+          buckets[b]++;
+        }
+      int max_count = *std::max_element (buckets.begin(), buckets.end());
+
+      result += "\n";
+      for (size_t b = 0; b < buckets.size(); b++)
+        {
+          const int bar_width = 40;
+          int bar = buckets[b] * bar_width / max_count;
+
+          result += string_printf ("  < %7d ms %6d %s\n", 1 << b, buckets[b], string (bar, '#').c_str());
+        }
+    }
+  result += "=====================================================================\n";
+  return result;
+}
+
+}
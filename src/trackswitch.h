@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef GST123_TRACK_SWITCH_H
+#define GST123_TRACK_SWITCH_H
+
+#include <gst/gst.h>
+#include <string>
+#include <vector>
+#include <atomic>
+
+namespace Gst123
+{
+
+/*
+ * Timing of the phases of a track switch
+ *
+ * start() is called when play_next() begins, and each phase is marked once
+ * it is complete, using a monotonic clock. Phases after setting the
+ * pipeline to PLAYING are marked from the bus sync handler (streaming
+ * thread) at the time the message is posted, so they are not delayed by
+ * main loop dispatching.
+ */
+class TrackSwitchStats
+{
+public:
+  enum Phase
+  {
+    TYPE_DETECTION,
+    TEARDOWN,
+    URI_SET,
+    STREAM_START,
+    PREROLL,
+    PLAYING,
+    N_PHASES
+  };
+
+private:
+  std::atomic<GstClockTime>  start_time;
+  std::atomic<GstClockTime>  marks[N_PHASES];     // 0 if not reached
+  std::vector<double>        samples[N_PHASES];   // phase durations in ms
+  std::vector<double>        total_samples;       // ms
+
+  static const char *phase_name (Phase phase);
+
+public:
+  TrackSwitchStats();
+
+  void start();
+  void mark (Phase phase);
+  bool complete() const;
+  void finish();
+  std::string format() const;
+};
+
+}
+
+#endif
@@ -0,0 +1,179 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+#include "uriresolver.h"
+#include <glib.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <string.h>
+
+using std::string;
+
+namespace Gst123
+{
+
+/* like gst_uri_is_valid(): "<scheme>:", where the scheme has at least two characters */
+bool
+UriResolver::has_scheme (const string& str)
+{
+  size_t i = 0;
+
+  if (str.empty() || !g_ascii_isalpha (str[0]))
+    return false;
+
+  while (i < str.size() && (g_ascii_isalnum (str[i]) || str[i] == '+' || str[i] == '-' || str[i] == '.'))
+    i++;
+
+  return i >= 2 && i < str.size() && str[i] == ':';
+}
+
+static const string&
+current_dir()
+{
+  static string *cwd = NULL;
+
+  if (g_once_init_enter (&cwd))
+    {
+      char *dir = g_get_current_dir();
+      string *result = new string (dir);
+      g_free (dir);
+
+      g_once_init_leave (&cwd, result);
+    }
+  return *cwd;
+}
+
+string
+UriResolver::join_path (const string& dir, const string& name)
+{
+  string result;
+
+  result.reserve (dir.size() + name.size() + 1);
+  result += dir;
+  if (!dir.empty() && dir[dir.size() - 1] != G_DIR_SEPARATOR)
+    result += G_DIR_SEPARATOR;
+  result += name;
+  return result;
+}
+
+string
+UriResolver::absolute_path (const string& path)
+{
+  if (g_path_is_absolute (path.c_str()))
+    return path;
+
+  return join_path (current_dir(), path);
+}
+
+/* characters which don't need to be escaped in the path of a file URI
+ * (same set as g_filename_to_uri() uses)
+ */
+static bool
+is_path_char (unsigned char c)
+{
+  return g_ascii_isalnum (c) || strchr ("-_.!~*'()/:@&=+$,", c);
+}
+
+string
+UriResolver::file_uri (const string& absolute_path)
+{
+  static const char hex[] = "0123456789ABCDEF";
+  static bool safe[256];
+  static gsize table_initialized = 0;
+
+  if (g_once_init_enter (&table_initialized))
+    {
+      for (int c = 0; c < 256; c++)
+        safe[c] = c != 0 && is_path_char (c);
+      g_once_init_leave (&table_initialized, 1);
+    }
+
+  string uri;
+  uri.reserve (7 + absolute_path.size() + absolute_path.size() / 4);
+  uri += "file://";
+
+  for (size_t i = 0; i < absolute_path.size(); i++)
+    {
+      unsigned char c = absolute_path[i];
+      if (safe[c])
+        {
+          uri += c;
+        }
+      else
+        {
+          uri += '%';
+          uri += hex[c >> 4];
+          uri += hex[c & 15];
+        }
+    }
+  return uri;
+}
+
+FileInfo
+UriResolver::file_info (const string& path)
+{
+#ifdef HAVE_STATX
+  /* we only need the file type, so statx can skip everything else */
+  struct statx stx;
+
+  if (statx (AT_FDCWD, path.c_str(), AT_SYMLINK_NOFOLLOW, STATX_TYPE, &stx) == 0)
+    {
+      if (S_ISDIR (stx.stx_mode))
+        return FI_DIR;
+      if (S_ISREG (stx.stx_mode))
+        return FI_REG;
+
+      if (statx (AT_FDCWD, path.c_str(), 0, STATX_TYPE, &stx) == 0 && S_ISREG (stx.stx_mode))
+        return FI_REG;
+      return FI_OTHER;
+    }
+  return FI_ERROR;
+#else
+  struct stat st;
+
+  if (lstat (path.c_str(), &st) == 0)
+    {
+      if (S_ISDIR (st.st_mode))
+        return FI_DIR;
+      else if (S_ISREG (st.st_mode))
+        return FI_REG;
+      else
+        {
+          if (stat (path.c_str(), &st) == 0 && S_ISREG (st.st_mode))
+            return FI_REG;
+          else
+            return FI_OTHER;
+        }
+    }
+  return FI_ERROR;
+#endif
+}
+
+string
+UriResolver::to_uri (const string& path_or_uri)
+{
+  if (has_scheme (path_or_uri))
+    return path_or_uri;
+
+  return file_uri (absolute_path (path_or_uri));
+}
+
+}
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef GST123_URI_RESOLVER_H
+#define GST123_URI_RESOLVER_H
+
+#include <string>
+
+namespace Gst123
+{
+
+enum FileInfo { FI_DIR, FI_REG, FI_OTHER, FI_ERROR };
+
+/*
+ * Converts command line arguments and playlist entries to URIs
+ *
+ * This is used for every entry of (possibly huge) playlists, so it avoids
+ * per entry allocations where glib would need them: the current directory
+ * is only queried once, and file URIs are percent-encoded using a table.
+ * All functions are thread safe.
+ */
+class UriResolver
+{
+public:
+  static bool has_scheme (const std::string& str);
+  static std::string absolute_path (const std::string& path);
+  static std::string join_path (const std::string& dir, const std::string& name);
+  static std::string file_uri (const std::string& absolute_path);
+  static FileInfo file_info (const std::string& path);
+
+  static std::string to_uri (const std::string& path_or_uri);
+};
+
+}
+
+#endif
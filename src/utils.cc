@@ -50,4 +50,34 @@ string_printf (const char *format, ...)
   return str;
 }
 
+string
+json_string (const string& str)
+{
+  string result = "\"";
+
+  for (size_t i = 0; i < str.size(); i++)
+    {
+      unsigned char ch = str[i];
+
+      if (ch == '"' || ch == '\\')
+        {
+          result += '\\';
+          result += ch;
+        }
+      else if (ch == '\n')
+        result += "\\n";
+      else if (ch == '\t')
+        result += "\\t";
+      else if (ch == '\r')
+        result += "\\r";
+      else if (ch < 0x20)
+        result += string_printf ("\\u%04x", ch);
+      else
+        result += ch;
+    }
+  result += '"';
+
+  return result;
+}
+
 }
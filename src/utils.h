@@ -29,6 +29,7 @@ namespace Gst123
 
 double get_time();
 std::string string_printf (const char *format, ...) G_GNUC_PRINTF (1, 2);
+std::string json_string (const std::string& str);
 
 }
 
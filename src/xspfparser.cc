@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/* GST123 - GStreamer based command line media player
+ * Copyright (C) 2026 Stefan Westerfeld
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "xspfparser.h"
+#include <glib.h>
+#include <cstring>
+#include <errno.h>
+
+using std::string;
+
+using namespace Gst123;
+
+struct XSPFState
+{
+  PlaylistEntryHandler *output;
+  int                   depth;           // element nesting depth
+  bool                  in_track;
+  string                field;           // track child element we collect the text of, or ""
+  string                text;
+  PlaylistEntry         entry;
+  bool                  have_location;
+  bool                  not_xspf;        // root element is not <playlist>
+};
+
+/* we don't care about namespace prefixes */
+static const char *
+local_name (const char *element_name)
+{
+  const char *colon = strrchr (element_name, ':');
+  return colon ? colon + 1 : element_name;
+}
+
+static void
+start_element (GMarkupParseContext *context, const char *element_name, const char **attribute_names,
+               const char **attribute_values, gpointer user_data, GError **error)
+{
+  XSPFState *state = static_cast<XSPFState *> (user_data);
+  const char *name = local_name (element_name);
+
+  state->depth++;
+  if (state->depth == 1 && strcmp (name, "playlist") != 0)
+    {
+      g_set_error (error, G_MARKUP_ERROR, G_MARKUP_ERROR_INVALID_CONTENT, "not an XSPF playlist");
+      state->not_xspf = true;
+      return;
+    }
+
+  // <playlist> <trackList> <track>
+  if (state->depth == 3 && strcmp (name, "track") == 0)
+    {
+      state->in_track = true;
+      state->entry = PlaylistEntry();
+      state->have_location = false;
+    }
+  else if (state->in_track && state->depth == 4)
+    {
+      if (strcmp (name, "location") == 0 || strcmp (name, "title") == 0 || strcmp (name, "duration") == 0)
+        {
+          state->field = name;
+          state->text = "";
+        }
+    }
+}
+
+static void
+end_element (GMarkupParseContext *context, const char *element_name, gpointer user_data, GError **error)
+{
+  XSPFState *state = static_cast<XSPFState *> (user_data);
+
+  if (state->in_track && state->depth == 4 && state->field != "")
+    {
+      string text = state->text;
+      while (!text.empty() && g_ascii_isspace (text[0]))
+        text.erase (0, 1);
+      while (!text.empty() && g_ascii_isspace (text[text.size() - 1]))
+        text.erase (text.size() - 1);
+
+      if (state->field == "location" && !state->have_location)  // a track may have alternative locations
+        {
+          state->entry.location = PlaylistParser::location_from_uri_reference (text);
+          state->have_location = text != "";
+        }
+      else if (state->field == "title")
+        {
+          state->entry.title = text;
+        }
+      else if (state->field == "duration")
+        {
+          double duration_ms = g_ascii_strtod (text.c_str(), NULL);
+          if (duration_ms > 0)
+            state->entry.duration = duration_ms / 1000;
+        }
+      state->field = "";
+    }
+  else if (state->in_track && state->depth == 3)
+    {
+      if (state->have_location)
+        state->output->add_entry (state->entry);
+      state->in_track = false;
+    }
+  state->depth--;
+}
+
+static void
+text (GMarkupParseContext *context, const char *text, gsize text_len, gpointer user_data, GError **error)
+{
+  XSPFState *state = static_cast<XSPFState *> (user_data);
+
+  if (state->field != "")
+    state->text.append (text, text_len);
+}
+
+static const char * const xspf_content_types[] = { "application/xspf+xml", NULL };
+
+// other XML files are rejected while parsing (if the root element is not <playlist>)
+static const char * const xspf_magics[] = { "<?xml", "<playlist", NULL };
+
+const PlaylistFormat&
+XSPFParser::format()
+{
+  static const PlaylistFormat xspf_format = { xspf_content_types, xspf_magics, false };
+  return xspf_format;
+}
+
+int
+XSPFParser::parse (PlaylistEntryHandler& output, IOStream *stream)
+{
+  static const GMarkupParser parser = { start_element, end_element, text, NULL, NULL };
+
+  XSPFState state;
+  state.output = &output;
+  state.depth = 0;
+  state.in_track = false;
+  state.have_location = false;
+  state.not_xspf = false;
+
+  GMarkupParseContext *context = g_markup_parse_context_new (&parser, GMarkupParseFlags (0), &state, NULL);
+  GError *error = NULL;
+  int ret = 0;
+
+  string data;
+  bool first_data = true;
+  while ((ret = stream->read_data (data)) >= 0)
+    {
+      // GMarkup doesn't expect a BOM
+      if (first_data && data.compare (0, 3, "\xef\xbb\xbf") == 0)
+        data.erase (0, 3);
+      if (!data.empty())
+        first_data = false;
+
+      if (!g_markup_parse_context_parse (context, data.c_str(), data.size(), &error))
+        break;
+    }
+
+  if (!error && ret == IO_STREAM_EOF)
+    g_markup_parse_context_end_parse (context, &error);
+
+  g_markup_parse_context_free (context);
+
+  if (error)
+    {
+      ret = state.not_xspf ? XSPF_ERROR_NOT_XSPF : XSPF_ERROR_SYNTAX;
+      error_message = error->message;
+      g_error_free (error);
+      return ret;
+    }
+
+  if (ret == IO_STREAM_EOF)  // EOF is not an error
+    ret = 0;
+
+  if (ret < 0)
+    ret = errno;
+
+  return ret;
+}
+
+string
+XSPFParser::str_error (int error)
+{
+  if (error == XSPF_ERROR_NOT_XSPF)
+    return "XML file is not an XSPF playlist";
+  if (error == XSPF_ERROR_SYNTAX)
+    return "XSPF parse error: " + error_message;
+  return "";
+}